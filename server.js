@@ -1,8 +1,9 @@
 const express = require('express');
-const multer = require('multer');
-const { execFile } = require('child_process');
+const busboy = require('busboy');
+const { spawn } = require('child_process');
 const path = require('path');
 const fs = require('fs');
+const os = require('os');
 const cors = require('cors');
 
 const app = express();
@@ -14,103 +15,281 @@ const PORT = process.env.PORT || 8080;
 // Enable CORS for all routes (utile si dev local, moins critique en prod sur même origine)
 app.use(cors());
 
-// Configure Multer for file uploads
-const uploadDir = path.join(__dirname, 'uploads');
-if (!fs.existsSync(uploadDir)) {
-    fs.mkdirSync(uploadDir);
-}
-
-const storage = multer.diskStorage({
-    destination: (req, file, cb) => {
-        cb(null, uploadDir);
-    },
-    filename: (req, file, cb) => {
-        // Use a unique name to avoid conflicts
-        cb(null, `${Date.now()}-${file.originalname}`);
-    }
-});
-
-const upload = multer({ storage: storage });
-
 // Determine the C binary executable name based on the OS
 const huffmanExecutable = process.platform === 'win32' ? 'huffman.exe' : './huffman';
 
-// --- Helper function for cleanup ---
-const cleanupFiles = (files) => {
-    files.forEach(filePath => {
-        if (filePath && fs.existsSync(filePath)) {
-            fs.unlink(filePath, (err) => {
-                if (err) console.error(`Failed to delete temporary file: ${filePath}`, err);
-            });
-        }
-    });
+// Nombre de binaires en parallèle (un cœur chacun, lancés avec -j 1) et taille
+// de la file d'attente au-delà de laquelle on répond 503
+const CORES = os.availableParallelism ? os.availableParallelism() : os.cpus().length;
+const WORKERS = Number(process.env.HUFFMAN_WORKERS) || CORES;
+const QUEUE_LIMIT = Number(process.env.HUFFMAN_QUEUE_LIMIT) || 4 * WORKERS;
+// Une requête qui attend depuis plus longtemps passe devant les plus petites
+const MAX_QUEUE_AGE_MS = Number(process.env.HUFFMAN_MAX_QUEUE_AGE_MS) || 10000;
+
+// --- Codec worker pool ---
+
+// Histogrammes cumulés au format Prometheus (secondes)
+const BUCKETS = [0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60];
+const histogram = () => ({ counts: BUCKETS.map(() => 0), count: 0, sum: 0 });
+const observe = (h, seconds) => {
+    h.count++;
+    h.sum += seconds;
+    BUCKETS.forEach((b, i) => { if (seconds <= b) h.counts[i]++; });
 };
 
-// --- API Routes ---
+const metrics = {
+    requests: { ok: 0, error: 0, rejected: 0, aborted: 0 },
+    wait: histogram(),
+    service: histogram(),
+};
 
-/**
- * @route POST /compress
- * @desc Reçoit un fichier texte, le compresse via le binaire C, et renvoie le fichier .huff.
- */
-app.post('/compress', upload.single('textFile'), (req, res) => {
-    if (!req.file) {
-        return res.status(400).send('No file uploaded.');
-    }
+let busy = 0;
+const queue = [];          // requêtes en attente, par ordre d'arrivée
+let serviceAvg = 1;        // moyenne glissante du temps de service (s), pour Retry-After
 
-    const inputPath = req.file.path;
-    const outputPath = `${inputPath}.huff`;
-    const outputFilename = `${req.file.originalname.split('.')[0]}.huff`;
+const elapsed = (since) => Number(process.hrtime.bigint() - since) / 1e9;
 
-    // Arguments: -c <input> <output>
-    execFile(huffmanExecutable, ['-c', inputPath, outputPath], (error, stdout, stderr) => {
-        if (error) {
-            console.error(`execFile error: ${error.message}`);
-            cleanupFiles([inputPath, outputPath]);
-            return res.status(500).send(`Compression failed: ${stderr || error.message}`);
-        }
-        
-        res.download(outputPath, outputFilename, (err) => {
-            if (err) console.error('Download error:', err);
-            cleanupFiles([inputPath, outputPath]);
-        });
+const run = (job) => {
+    busy++;
+    observe(metrics.wait, elapsed(job.enqueued));
+    const granted = process.hrtime.bigint();
+    let released = false;
+    job.start((outcome) => {
+        if (released) return;
+        released = true;
+        busy--;
+        metrics.requests[outcome]++;
+        const s = elapsed(granted);
+        observe(metrics.service, s);
+        serviceAvg = 0.8 * serviceAvg + 0.2 * s;
+        dispatch();
     });
-});
+};
+
+// Plus petite requête d'abord ; la plus ancienne si elle attend depuis trop longtemps
+const pick = () => {
+    if (elapsed(queue[0].enqueued) * 1000 > MAX_QUEUE_AGE_MS) return 0;
+    let best = 0;
+    for (let i = 1; i < queue.length; i++) {
+        if (queue[i].size < queue[best].size) best = i;
+    }
+    return best;
+};
+
+const dispatch = () => {
+    while (busy < WORKERS && queue.length > 0) run(queue.splice(pick(), 1)[0]);
+};
 
 /**
- * @route POST /decompress
- * @desc Reçoit un fichier .huff, le décompresse via le binaire C, et renvoie le texte.
+ * Demande une place de codage pour une requête de size octets. start(done) est
+ * appelé dès qu'un worker est libre ; done(outcome) le rend ('ok', 'error' ou
+ * 'aborted'). Retourne null si la file est pleine.
  */
-app.post('/decompress', upload.single('textFile'), (req, res) => {
-    if (!req.file) {
-        return res.status(400).send('No file uploaded.');
+const acquire = (size, start) => {
+    const job = { size, enqueued: process.hrtime.bigint(), start };
+    if (busy < WORKERS) {
+        run(job);
+    } else if (queue.length < QUEUE_LIMIT) {
+        queue.push(job);
+    } else {
+        return null;
     }
+    return job;
+};
+
+// Client parti avant d'avoir été servi
+const cancel = (job) => {
+    const i = queue.indexOf(job);
+    if (i < 0) return;
+    queue.splice(i, 1);
+    metrics.requests.aborted++;
+};
+
+const retryAfter = () => Math.max(1, Math.ceil(serviceAvg * (queue.length + 1) / WORKERS));
 
-    const inputPath = req.file.path;
+// --- Output file names ---
+
+const compressedName = (originalName) => `${originalName.split('.')[0]}.huff`;
+
+const decompressedName = (originalName) => {
     // On tente de retirer l'extension .huff pour le nom de sortie
-    let outputFilename = req.file.originalname.replace('.huff', '');
+    let outputFilename = originalName.replace('.huff', '');
     // Si le nom n'a pas changé (pas de .huff), on ajoute .txt par sécurité
-    if (outputFilename === req.file.originalname) {
+    if (outputFilename === originalName) {
         outputFilename += '.txt';
     } else if (!outputFilename.includes('.')) {
         // Si après retrait de .huff il n'y a plus d'extension, on remet .txt
         outputFilename += '.txt';
     }
-    
-    const outputPath = path.join(path.dirname(inputPath), `decompressed-${Date.now()}.txt`);
-
-    // Arguments: -d <input> <output>
-    execFile(huffmanExecutable, ['-d', inputPath, outputPath], (error, stdout, stderr) => {
-        if (error) {
-            console.error(`execFile error: ${error.message}`);
-            cleanupFiles([inputPath, outputPath]);
-            return res.status(500).send(`Decompression failed: ${stderr || error.message}`);
+    return outputFilename;
+};
+
+// --- Streaming pipeline ---
+
+/**
+ * Fait passer le fichier 'textFile' d'un formulaire multipart dans le binaire C
+ * sans fichier temporaire : le corps de la requête est découpé au fil de l'eau
+ * par busboy, la partie fichier est envoyée sur stdin de `huffman <flag> - -`,
+ * et stdout est renvoyé directement dans la réponse (le premier octet part dès
+ * que le premier bloc est codé).
+ *
+ * Les en-têtes ne partent qu'avec le premier octet de sortie : un échec du
+ * binaire avant ce moment donne encore une erreur 500 avec son stderr. Un échec
+ * plus tardif coupe la connexion, pour que le client ne prenne pas une sortie
+ * tronquée pour un fichier complet.
+ *
+ * done(outcome) est appelé une seule fois, quand le binaire est terminé ou que
+ * la requête échoue avant de l'avoir lancé.
+ */
+const streamThroughCodec = (req, res, flag, label, outputName, done) => {
+    let bb;
+    try {
+        bb = busboy({ headers: req.headers, defParamCharset: 'utf8', limits: { files: 1 } });
+    } catch (err) {
+        done('error');
+        return res.status(400).send('Expected a multipart/form-data upload.');
+    }
+
+    let child = null;
+    let finished = false;
+    const finish = (outcome) => {
+        finished = true;
+        done(outcome);
+    };
+
+    bb.on('file', (fieldName, file, info) => {
+        if (fieldName !== 'textFile' || child) {
+            file.resume();
+            return;
         }
 
-        res.download(outputPath, outputFilename, (err) => {
-            if (err) console.error('Download error:', err);
-            cleanupFiles([inputPath, outputPath]);
+        child = spawn(huffmanExecutable, ['-j', '1', flag, '-', '-'], { stdio: ['pipe', 'pipe', 'pipe'] });
+        let stderr = '';
+        let started = false;
+        // Même en-têtes que res.download (type d'après l'extension), sans Content-Length
+        const start = () => {
+            started = true;
+            res.attachment(outputName(info.filename || 'file'));
+        };
+
+        child.stderr.on('data', (chunk) => { stderr += chunk; });
+        // EPIPE si le binaire s'arrête avant la fin de l'envoi : le code de sortie fait foi
+        child.stdin.on('error', () => {});
+        file.pipe(child.stdin);
+
+        child.stdout.once('data', start);
+        child.stdout.pipe(res, { end: false });
+
+        child.on('error', (err) => {
+            console.error(`spawn error: ${err.message}`);
+            if (finished) return;
+            finish('error');
+            if (!res.headersSent) res.status(500).send(`${label} failed: ${err.message}`);
+        });
+
+        child.on('close', (code, signal) => {
+            if (finished) return;
+            if (code === 0) {
+                finish('ok');
+                if (!started) start();
+                return res.end();
+            }
+            finish(res.destroyed ? 'aborted' : 'error');
+            const reason = stderr.trim() || `exit ${code === null ? signal : code}`;
+            console.error(`${label} error: ${reason}`);
+            if (!started) return res.status(500).send(`${label} failed: ${reason}`);
+            res.destroy();
         });
     });
+
+    bb.on('close', () => {
+        if (!child && !finished) {
+            finish('error');
+            res.status(400).send('No file uploaded.');
+        }
+    });
+
+    bb.on('error', (err) => {
+        if (child) return child.kill(); // 'close' du binaire termine la requête
+        if (!finished) {
+            finish('error');
+            res.status(400).send(`Invalid upload: ${err.message}`);
+        }
+    });
+
+    // Client parti en cours de route : inutile de continuer à coder
+    res.on('close', () => {
+        if (!child) {
+            if (!finished) finish('aborted');
+        } else if (child.exitCode === null && child.signalCode === null) {
+            child.kill();
+        }
+    });
+
+    req.pipe(bb);
+};
+
+/**
+ * Passe la requête par le pool : le corps n'est lu qu'une fois un worker
+ * attribué (d'ici là, TCP retient l'envoi). La taille annoncée par
+ * Content-Length fixe la priorité ; sans elle, la requête passe après les autres.
+ */
+const limited = (flag, label, outputName) => (req, res) => {
+    const size = Number(req.headers['content-length']);
+    const job = acquire(Number.isFinite(size) ? size : Infinity, (done) => {
+        streamThroughCodec(req, res, flag, label, outputName, done);
+    });
+    if (!job) {
+        metrics.requests.rejected++;
+        // le corps n'est pas lu : la connexion ne peut pas être réutilisée
+        res.set('Retry-After', String(retryAfter()));
+        res.set('Connection', 'close');
+        return res.status(503).send('Server busy, retry later.');
+    }
+    res.on('close', () => cancel(job));
+};
+
+// --- API Routes ---
+
+/**
+ * @route POST /compress
+ * @desc Reçoit un fichier texte, le compresse via le binaire C, et renvoie le fichier .huff.
+ */
+app.post('/compress', limited('-c', 'Compression', compressedName));
+
+/**
+ * @route POST /decompress
+ * @desc Reçoit un fichier .huff, le décompresse via le binaire C, et renvoie le texte.
+ */
+app.post('/decompress', limited('-d', 'Decompression', decompressedName));
+
+/**
+ * @route GET /metrics
+ * @desc État du pool au format texte Prometheus : workers, file d'attente,
+ * requêtes par issue, temps d'attente et de service.
+ */
+app.get('/metrics', (req, res) => {
+    const lines = [];
+    const gauge = (name, help, value) => {
+        lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} gauge`, `${name} ${value}`);
+    };
+    const hist = (name, help, h) => {
+        lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} histogram`);
+        BUCKETS.forEach((b, i) => lines.push(`${name}_bucket{le="${b}"} ${h.counts[i]}`));
+        lines.push(`${name}_bucket{le="+Inf"} ${h.count}`, `${name}_sum ${h.sum}`, `${name}_count ${h.count}`);
+    };
+    gauge('huffman_workers', 'Codec worker slots.', WORKERS);
+    gauge('huffman_workers_busy', 'Codec workers currently running the binary.', busy);
+    gauge('huffman_queue_depth', 'Requests waiting for a worker.', queue.length);
+    gauge('huffman_queue_limit', 'Queue depth above which requests get 503.', QUEUE_LIMIT);
+    lines.push('# HELP huffman_requests_total Codec requests by outcome.', '# TYPE huffman_requests_total counter');
+    for (const [outcome, n] of Object.entries(metrics.requests)) {
+        lines.push(`huffman_requests_total{outcome="${outcome}"} ${n}`);
+    }
+    hist('huffman_queue_wait_seconds', 'Time from arrival to worker assignment.', metrics.wait);
+    hist('huffman_service_seconds', 'Time a worker spends on a request.', metrics.service);
+    res.type('text/plain; version=0.0.4');
+    res.send(lines.join('\n') + '\n');
 });
 
 // --- SERVING FRONTEND (AJOUT CRITIQUE) ---
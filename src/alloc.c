@@ -0,0 +1,185 @@
+/*
+ * alloc.c
+ *
+ * - allocateur courant : pointeurs de fonctions globaux (libc par défaut),
+ * - allocateur de comptage : chaque bloc est précédé d'un en-tête qui garde
+ *   sa taille (aligné comme max_align_t), compteurs atomiques ; le pic est mis
+ *   à jour par compare-and-swap. Chaque opération est comptée deux fois : au
+ *   total du processus et dans la portée du thread (variable _Thread_local).
+ */
+
+#include "alloc.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------- Libc ---------- */
+
+static void *libc_alloc(void *ctx, size_t n) {
+    (void) ctx;
+    return malloc(n);
+}
+
+static void *libc_resize(void *ctx, void *p, size_t n) {
+    (void) ctx;
+    return realloc(p, n);
+}
+
+static void libc_release(void *ctx, void *p) {
+    (void) ctx;
+    free(p);
+}
+
+static HfAllocator courant = { libc_alloc, libc_resize, libc_release, NULL };
+
+void hf_set_allocator(const HfAllocator *a) {
+    if (a && a->alloc && a->resize && a->release) {
+        courant = *a;
+    } else {
+        courant.alloc = libc_alloc;
+        courant.resize = libc_resize;
+        courant.release = libc_release;
+        courant.ctx = NULL;
+    }
+}
+
+void *hf_malloc(size_t n) {
+    return courant.alloc(courant.ctx, n);
+}
+
+void *hf_calloc(size_t nmemb, size_t size) {
+    if (size != 0 && nmemb > SIZE_MAX / size) return NULL;
+    void *p = courant.alloc(courant.ctx, nmemb * size);
+    if (p) memset(p, 0, nmemb * size);
+    return p;
+}
+
+void *hf_realloc(void *p, size_t n) {
+    return courant.resize(courant.ctx, p, n);
+}
+
+void hf_free(void *p) {
+    if (p) courant.release(courant.ctx, p);
+}
+
+/* ---------- Comptage ---------- */
+
+typedef union {
+    size_t taille;
+    max_align_t align;
+} EnTete;
+
+/* total du processus : une portée jamais fermée */
+static HfAllocScope total;
+static _Thread_local HfAllocScope *portee = NULL;
+
+static void noter_pic(HfAllocScope *s, uint64_t c) {
+    uint_fast64_t p = atomic_load(&s->peak);
+    while (c > p && !atomic_compare_exchange_weak(&s->peak, &p, c)) {
+    }
+}
+
+static void noter_alloc(HfAllocScope *s, size_t n) {
+    atomic_fetch_add(&s->allocations, 1);
+    atomic_fetch_add(&s->bytes, n);
+    noter_pic(s, atomic_fetch_add(&s->current, n) + n);
+}
+
+static void noter_resize(HfAllocScope *s, size_t ancienne, size_t n) {
+    atomic_fetch_add(&s->reallocations, 1);
+    if (n > ancienne) {
+        atomic_fetch_add(&s->bytes, n - ancienne);
+        noter_pic(s, atomic_fetch_add(&s->current, n - ancienne) + (n - ancienne));
+    } else {
+        atomic_fetch_sub(&s->current, ancienne - n);
+    }
+}
+
+static void noter_free(HfAllocScope *s, size_t n) {
+    atomic_fetch_add(&s->frees, 1);
+    atomic_fetch_sub(&s->current, n);
+}
+
+static void *compte_alloc(void *ctx, size_t n) {
+    (void) ctx;
+    if (n > SIZE_MAX - sizeof(EnTete)) return NULL;
+    EnTete *h = (EnTete*) malloc(sizeof(EnTete) + n);
+    if (!h) return NULL;
+    h->taille = n;
+    noter_alloc(&total, n);
+    if (portee) noter_alloc(portee, n);
+    return h + 1;
+}
+
+static void compte_release(void *ctx, void *p) {
+    (void) ctx;
+    if (!p) return;
+    EnTete *h = (EnTete*) p - 1;
+    noter_free(&total, h->taille);
+    if (portee) noter_free(portee, h->taille);
+    free(h);
+}
+
+static void *compte_resize(void *ctx, void *p, size_t n) {
+    if (!p) return compte_alloc(ctx, n);
+    if (n > SIZE_MAX - sizeof(EnTete)) return NULL;
+    EnTete *h = (EnTete*) p - 1;
+    size_t ancienne = h->taille;
+    EnTete *nh = (EnTete*) realloc(h, sizeof(EnTete) + n);
+    if (!nh) return NULL;
+    nh->taille = n;
+    noter_resize(&total, ancienne, n);
+    if (portee) noter_resize(portee, ancienne, n);
+    return nh + 1;
+}
+
+static const HfAllocator comptage = { compte_alloc, compte_resize, compte_release, NULL };
+
+const HfAllocator *hf_counting_allocator(void) {
+    return &comptage;
+}
+
+int hf_alloc_counting(void) {
+    return courant.alloc == compte_alloc;
+}
+
+static void copier_stats(HfAllocScope *s, HfAllocStats *st) {
+    st->allocations = atomic_load(&s->allocations);
+    st->reallocations = atomic_load(&s->reallocations);
+    st->frees = atomic_load(&s->frees);
+    st->bytes = atomic_load(&s->bytes);
+    st->current = atomic_load(&s->current);
+    st->peak = atomic_load(&s->peak);
+}
+
+void hf_alloc_stats(HfAllocStats *st) {
+    if (st) copier_stats(&total, st);
+}
+
+void hf_alloc_scope_begin(HfAllocScope *s) {
+    if (!s) return;
+    atomic_init(&s->allocations, 0);
+    atomic_init(&s->reallocations, 0);
+    atomic_init(&s->frees, 0);
+    atomic_init(&s->bytes, 0);
+    atomic_init(&s->current, 0);
+    atomic_init(&s->peak, 0);
+    s->parent = portee;
+    portee = s;
+}
+
+void hf_alloc_scope_end(HfAllocScope *s, HfAllocStats *st) {
+    if (!s) return;
+    if (portee == s) portee = s->parent;
+    if (st) copier_stats(s, st);
+}
+
+HfAllocScope *hf_alloc_scope_current(void) {
+    return portee;
+}
+
+HfAllocScope *hf_alloc_scope_swap(HfAllocScope *s) {
+    HfAllocScope *avant = portee;
+    portee = s;
+    return avant;
+}
@@ -0,0 +1,97 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+/*
+ * alloc.h
+ *
+ * Allocateur du codec : les modules de compression (arbre et tas Huffman,
+ * BitWriter / BitReader, tampons de blocs, LZ77, BWT, archive, magasin)
+ * allouent par hf_malloc / hf_calloc / hf_realloc / hf_free, qui délèguent à
+ * l'allocateur installé (celui de la libc par défaut).
+ *
+ * L'allocateur de comptage intégré tient le nombre d'allocations, les octets
+ * demandés et le pic d'octets vivants, pour tout le processus (tous threads)
+ * et pour la portée (HfAllocScope) du thread appelant. Une portée mesure un
+ * appel (un fichier de --batch, une commande -c / -d / -t) même si d'autres
+ * tournent en même temps : les tâches soumises au pool (pool.h) héritent de
+ * la portée du thread qui les soumet.
+ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Allocateur branchable : mêmes contrats que malloc / realloc / free
+ * (resize(ctx, NULL, n) == alloc(ctx, n), release(ctx, NULL) sans effet).
+ * Les fonctions doivent pouvoir être appelées depuis plusieurs threads.
+ */
+typedef struct HfAllocator {
+    void *(*alloc)(void *ctx, size_t n);
+    void *(*resize)(void *ctx, void *p, size_t n);
+    void (*release)(void *ctx, void *p);
+    void *ctx;
+} HfAllocator;
+
+typedef struct HfAllocStats {
+    uint64_t allocations;    /* blocs obtenus (hf_malloc, hf_calloc, hf_realloc(NULL, n)) */
+    uint64_t reallocations;  /* hf_realloc d'un bloc existant */
+    uint64_t frees;
+    uint64_t bytes;          /* octets demandés au total (allocations + agrandissements) */
+    uint64_t current;        /* octets vivants */
+    uint64_t peak;           /* maximum de current (depuis le début de la portée) */
+} HfAllocStats;
+
+/* Compteurs d'une portée (voir hf_alloc_scope_begin), en général sur la pile
+ * de l'appelant. Une libération est décomptée de la portée où elle a lieu :
+ * un bloc alloué dans une portée doit y être libéré.
+ */
+typedef struct HfAllocScope {
+    atomic_uint_fast64_t allocations;
+    atomic_uint_fast64_t reallocations;
+    atomic_uint_fast64_t frees;
+    atomic_uint_fast64_t bytes;
+    atomic_uint_fast64_t current;
+    atomic_uint_fast64_t peak;
+    struct HfAllocScope *parent;   /* portée du thread avant hf_alloc_scope_begin */
+} HfAllocScope;
+
+/* Installe a (copié) ; NULL rétablit la libc. À appeler avant toute
+ * allocation du codec : un bloc doit être libéré par l'allocateur qui l'a
+ * fourni.
+ */
+void hf_set_allocator(const HfAllocator *a);
+
+/* Allocateur de comptage intégré (libc + en-tête de taille), à passer à
+ * hf_set_allocator. */
+const HfAllocator *hf_counting_allocator(void);
+
+/* 1 si l'allocateur de comptage est installé. */
+int hf_alloc_counting(void);
+
+/* Statistiques de tout le processus (zéros si l'allocateur de comptage n'a
+ * pas servi). */
+void hf_alloc_stats(HfAllocStats *st);
+
+/* Ouvre la portée s (compteurs à zéro) sur le thread appelant : ses
+ * allocations y sont comptées, en plus du total du processus, jusqu'à
+ * hf_alloc_scope_end. Les portées s'imbriquent ; seule la plus interne compte.
+ */
+void hf_alloc_scope_begin(HfAllocScope *s);
+
+/* Ferme s, rétablit la portée précédente du thread et copie ses compteurs
+ * dans st (peut être NULL). */
+void hf_alloc_scope_end(HfAllocScope *s, HfAllocStats *st);
+
+/* Portée du thread appelant (NULL hors de toute portée), et changement de
+ * portée sans remise à zéro : le pool s'en sert pour exécuter une tâche dans
+ * la portée de celui qui l'a soumise. Retourne la portée remplacée.
+ */
+HfAllocScope *hf_alloc_scope_current(void);
+HfAllocScope *hf_alloc_scope_swap(HfAllocScope *s);
+
+void *hf_malloc(size_t n);
+void *hf_calloc(size_t nmemb, size_t size);
+void *hf_realloc(void *p, size_t n);
+void hf_free(void *p);
+
+#endif /* ALLOC_H */
@@ -0,0 +1,1146 @@
+/*
+ * archive.c
+ *
+ * Conteneur HUF2 (voir archive.h) :
+ * - écriture séquentielle des blocs, du segment d'index et du pied,
+ * - ajout de blocs à une archive existante (-a),
+ * - découpage FastCDC + références au magasin de chunks (--store),
+ * - décodage séquentiel,
+ * - lecture de l'index, encodage / décodage parallèles par segments de blocs,
+ * - sommes de contrôle par bloc et mode test (-t).
+ *
+ * Le codage de chaque bloc est délégué à codec.c.
+ */
+
+#define _POSIX_C_SOURCE 200809L   /* fseeko / ftello / pread / pwrite */
+#define _FILE_OFFSET_BITS 64
+
+#include "archive.h"
+#include "codec.h"
+#include "lz77.h"
+#include "split.h"
+#include "chunker.h"
+#include "store.h"
+#include "pool.h"
+#include "io.h"
+#include "hash.h"
+#include "outfile.h"
+#include "alloc.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ---------- Entiers big-endian en mémoire ---------- */
+
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char) (v >> 8);
+    p[1] = (unsigned char) v;
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char) (v >> (24 - 8 * i));
+}
+
+static void put_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char) (v >> (56 - 8 * i));
+}
+
+static uint16_t get_u16(const unsigned char *p) {
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+void hf_options_defaut(HfOptions *opt) {
+    if (!opt) return;
+    opt->block_size = HF2_DEFAULT_BLOCK_SIZE;
+    opt->store_dir = NULL;
+    opt->checksum = HF_CHECKSUM_CRC32C;
+    opt->codec = HF_CODEC_HUFF;
+    opt->level = LZ_LEVEL_DEFAULT;
+    opt->split = 1;
+}
+
+/* Préréglages des niveaux : ordre 0 en blocs fixes, ordre 0 à frontières
+ * adaptatives, LZ77 d'effort croissant, puis BWT (contexte trié) sur des blocs
+ * de plus en plus grands. */
+typedef struct HfNiveau {
+    int codec;
+    int level;               /* effort LZ77 */
+    int split;
+    size_t block_size;
+} HfNiveau;
+
+static const HfNiveau niveaux[HF_LEVEL_MAX + 1] = {
+    { 0, 0, 0, 0 },
+    { HF_CODEC_HUFF, LZ_LEVEL_DEFAULT, 0, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_HUFF, LZ_LEVEL_DEFAULT, 1, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_LZ,   1,                1, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_LZ,   3,                1, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_LZ,   4,                1, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_LZ,   6,                1, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_LZ,   7,                1, HF2_DEFAULT_BLOCK_SIZE },
+    { HF_CODEC_BWT,  LZ_LEVEL_DEFAULT, 1, HF_BWT_BLOCK_SIZE },
+    { HF_CODEC_BWT,  LZ_LEVEL_DEFAULT, 1, 4 * HF_BWT_BLOCK_SIZE },
+};
+
+int hf_options_level(HfOptions *opt, int level) {
+    if (!opt || level < HF_LEVEL_MIN || level > HF_LEVEL_MAX) return -1;
+    const HfNiveau *n = &niveaux[level];
+    opt->codec = n->codec;
+    opt->level = n->level;
+    opt->split = n->split;
+    opt->block_size = n->block_size;
+    return 0;
+}
+
+/* ---------- Sommes de contrôle ---------- */
+
+static int flags_checksum(int checksum) {
+    if (checksum == HF_CHECKSUM_CRC32C) return HF2_FLAG_CRC32C;
+    if (checksum == HF_CHECKSUM_XXH64) return HF2_FLAG_XXH64;
+    return 0;
+}
+
+static size_t checksum_size(int file_flags) {
+    if (file_flags & HF2_FLAG_XXH64) return 8;
+    if (file_flags & HF2_FLAG_CRC32C) return 4;
+    return 0;
+}
+
+static uint64_t checksum(int file_flags, const unsigned char *raw, size_t n) {
+    TRACE_DEBUT(t);
+    uint64_t c = 0;
+    if (file_flags & HF2_FLAG_XXH64) c = xxh64(raw, n, 0);
+    else if (file_flags & HF2_FLAG_CRC32C) c = crc32c(raw, n);
+    TRACE_FIN(t, "somme de contrôle", n);
+    return c;
+}
+
+/* Taille de l'en-tête de bloc (somme de contrôle comprise) pour ces drapeaux fichier. */
+static size_t block_header_size(int file_flags) {
+    return HF2_BLOCK_HEADER_SIZE + checksum_size(file_flags);
+}
+
+size_t archive_block_header_size(int file_flags) {
+    return block_header_size(file_flags);
+}
+
+/* Entropie d'un bloc (bits par octet) telle que rangée dans l'index. */
+static uint16_t entropie_index(double h) {
+    if (h < 0.0) h = 0.0;
+    if (h > 8.0) h = 8.0;
+    return (uint16_t) (HF2_ENTROPY_KNOWN | (uint16_t) (h * HF2_ENTROPY_SCALE + 0.5));
+}
+
+static uint64_t lire_checksum(int file_flags, const unsigned char *h) {
+    if (file_flags & HF2_FLAG_XXH64) return get_u64(h + HF2_BLOCK_HEADER_SIZE);
+    if (file_flags & HF2_FLAG_CRC32C) return get_u32(h + HF2_BLOCK_HEADER_SIZE);
+    return 0;
+}
+
+/* Écrit l'en-tête de bloc dans h ; retourne sa taille. */
+static size_t format_block_header(unsigned char h[HF2_MAX_BLOCK_HEADER_SIZE], int file_flags,
+                                  int codec, int flags, uint32_t raw_size, uint32_t payload_size,
+                                  uint64_t csum) {
+    h[0] = (unsigned char) codec;
+    h[1] = (unsigned char) flags;
+    put_u16(h + 2, 0);
+    put_u32(h + 4, raw_size);
+    put_u32(h + 8, payload_size);
+    if (file_flags & HF2_FLAG_XXH64) put_u64(h + HF2_BLOCK_HEADER_SIZE, csum);
+    else if (file_flags & HF2_FLAG_CRC32C) put_u32(h + HF2_BLOCK_HEADER_SIZE, (uint32_t) csum);
+    return block_header_size(file_flags);
+}
+
+/* ---------- Écriture ---------- */
+
+/* État d'écriture d'un segment : blocs écrits depuis l'ouverture. */
+typedef struct ArchiveWriter {
+    FILE *out;
+    uint64_t offset;          /* position courante dans le fichier */
+    HfIndexEntry *entries;      /* blocs du segment courant */
+    size_t n, cap;
+    uint32_t block_count;     /* total, segments précédents compris */
+    uint64_t total_raw;       /* total, segments précédents compris */
+    uint64_t prev_index;      /* offset du segment d'index précédent (0 = aucun) */
+    int file_flags;           /* drapeaux de l'en-tête fichier (somme de contrôle) */
+} ArchiveWriter;
+
+static int writer_put(ArchiveWriter *w, const void *data, size_t len) {
+    if (len > 0 && fwrite(data, 1, len, w->out) != len) return -1;
+    w->offset += len;
+    return 0;
+}
+
+/* Ajoute un bloc à l'index du segment courant (ne l'écrit pas). */
+static int writer_add_entry(ArchiveWriter *w, const HfIndexEntry *e) {
+    if (w->n == w->cap) {
+        size_t nc = (w->cap == 0) ? 64 : w->cap * 2;
+        HfIndexEntry *tmp = (HfIndexEntry*) hf_realloc(w->entries, nc * sizeof(HfIndexEntry));
+        if (!tmp) return -1;
+        w->entries = tmp;
+        w->cap = nc;
+    }
+    w->entries[w->n++] = *e;
+    w->block_count++;
+    w->total_raw += e->raw_size;
+    return 0;
+}
+
+static int writer_block(ArchiveWriter *w, int codec, int flags, uint16_t entropy,
+                        const unsigned char *payload, size_t payload_len,
+                        const unsigned char *raw, size_t raw_len) {
+    HfIndexEntry e;
+    e.offset = w->offset;
+    e.raw_size = (uint32_t) raw_len;
+    e.payload_size = (uint32_t) payload_len;
+    e.codec = (unsigned char) codec;
+    e.flags = (unsigned char) flags;
+    e.entropy = entropy;
+
+    unsigned char h[HF2_MAX_BLOCK_HEADER_SIZE];
+    size_t hs = format_block_header(h, w->file_flags, e.codec, e.flags, e.raw_size, e.payload_size,
+                                    checksum(w->file_flags, raw, raw_len));
+    if (writer_put(w, h, hs) != 0) return -1;
+    if (writer_put(w, payload, payload_len) != 0) return -1;
+    return writer_add_entry(w, &e);
+}
+
+static int writer_header(ArchiveWriter *w, int flags) {
+    w->file_flags = flags;
+    unsigned char h[HF2_FILE_HEADER_SIZE];
+    memcpy(h, HF2_MAGIC, 4);
+    h[4] = HF2_VERSION;
+    h[5] = (unsigned char) flags;
+    put_u16(h + 6, 0);
+    TRACE_DEBUT(t);
+    int rc = writer_put(w, h, sizeof(h));
+    TRACE_FIN(t, "écriture en-tête", sizeof(h));
+    return rc;
+}
+
+/* Écrit le segment d'index des blocs du segment courant puis le pied. */
+static int ecrire_index_pied(ArchiveWriter *w) {
+    uint64_t index_offset = w->offset;
+    unsigned char h[HF2_INDEX_HEADER_SIZE];
+    memset(h, 0, sizeof(h));
+    h[0] = HF2_TAG_INDEX;
+    put_u32(h + 4, (uint32_t) w->n);
+    put_u64(h + 8, w->prev_index);
+    if (writer_put(w, h, sizeof(h)) != 0) return -1;
+
+    for (size_t i = 0; i < w->n; ++i) {
+        unsigned char e[HF2_INDEX_ENTRY_SIZE];
+        put_u64(e, w->entries[i].offset);
+        put_u32(e + 8, w->entries[i].raw_size);
+        put_u32(e + 12, w->entries[i].payload_size);
+        e[16] = w->entries[i].codec;
+        e[17] = w->entries[i].flags;
+        put_u16(e + 18, w->entries[i].entropy);
+        if (writer_put(w, e, sizeof(e)) != 0) return -1;
+    }
+
+    unsigned char f[HF2_FOOTER_SIZE];
+    memset(f, 0, sizeof(f));
+    f[0] = HF2_TAG_FOOTER;
+    put_u32(f + 4, w->block_count);
+    put_u64(f + 8, w->total_raw);
+    put_u64(f + 16, index_offset);
+    memcpy(f + 28, HF2_FOOTER_MAGIC, 4);
+    return writer_put(w, f, sizeof(f));
+}
+
+static int writer_finish(ArchiveWriter *w) {
+    TRACE_DEBUT(t);
+    int rc = ecrire_index_pied(w);
+    TRACE_FIN(t, "écriture index", w->n);
+    return rc;
+}
+
+/* ---------- Découpage en blocs ---------- */
+
+/* Blocs par fenêtre (et par tâche en parallèle) : environ HF2_SEGMENT_BLOCKS
+ * blocs de taille par défaut de données brutes (1 Mio), entre 1 et
+ * HF2_SEGMENT_BLOCKS blocs. Les gros blocs (BWT) restent ainsi répartis sur
+ * les threads.
+ */
+static size_t blocs_par_segment(size_t block_size) {
+    size_t n = (block_size > 0) ? (size_t) HF2_SEGMENT_BLOCKS * HF2_DEFAULT_BLOCK_SIZE / block_size : 1;
+    if (n < 1) n = 1;
+    if (n > HF2_SEGMENT_BLOCKS) n = HF2_SEGMENT_BLOCKS;
+    return n;
+}
+
+/* Le découpage adaptatif ne concerne que les codecs d'ordre 0, dont le coût
+ * se prévoit d'après l'histogramme. */
+static int decoupage_adaptatif(int codec, int split) {
+    return split && (codec == HF_CODEC_HUFF || codec == HF_CODEC_PAIRS);
+}
+
+/* Longueur du prochain bloc dans une fenêtre p[0..n) : frontière choisie par
+ * split.c (coût d'un bloc en plus : table, en-tête, entrée d'index) ou taille
+ * fixe bs. Les fenêtres ont les mêmes frontières en séquentiel et en
+ * parallèle, la sortie est donc identique.
+ */
+static size_t longueur_bloc(const unsigned char *p, size_t n, size_t bs, int codec, int split,
+                            int file_flags) {
+    if (decoupage_adaptatif(codec, split)) {
+        return split_next_block(p, n, n, HF_TABLE_BYTES + block_header_size(file_flags) +
+                                         HF2_INDEX_ENTRY_SIZE);
+    }
+    return (n < bs) ? n : bs;
+}
+
+/* Nombre maximal de blocs dans une fenêtre de n octets. */
+static size_t blocs_max(size_t n, size_t bs, int codec, int split) {
+    size_t min = decoupage_adaptatif(codec, split) ? SPLIT_STEP : bs;
+    if (min > bs) min = bs;
+    return n / min + 1;
+}
+
+/* Lit in par fenêtres de blocs_par_segment blocs, découpe, encode et écrit
+ * chaque bloc. */
+static int writer_encode_all(ArchiveWriter *w, FILE *in, const HfOptions *opt) {
+    size_t bs = opt->block_size;
+    if (bs == 0 || bs > HF2_MAX_BLOCK_SIZE) return -1;
+    size_t fenetre = bs * blocs_par_segment(bs);
+
+    unsigned char *raw = (unsigned char*) hf_malloc(fenetre);
+    size_t cap = codec_bound(fenetre) + 16;
+    unsigned char *payload = (unsigned char*) hf_malloc(cap);
+    CodecTable *tab = (CodecTable*) hf_malloc(sizeof(CodecTable));
+    if (!raw || !payload || !tab) {
+        hf_free(raw);
+        hf_free(payload);
+        hf_free(tab);
+        return -1;
+    }
+
+    int rc = 0;
+    for (;;) {
+        TRACE_DEBUT(t_lecture);
+        size_t r = fread(raw, 1, fenetre, in);
+        TRACE_FIN(t_lecture, "lecture", r);
+        if (r == 0) break;
+        /* une table n'est reprise qu'à l'intérieur d'une fenêtre, comme en parallèle */
+        codec_table_reset(tab);
+        for (size_t done = 0; done < r;) {
+            TRACE_DEBUT(t_bloc);
+            size_t n = longueur_bloc(raw + done, r - done, bs, opt->codec, opt->split, w->file_flags);
+            int codec, flags;
+            size_t plen;
+            double h;
+            if (codec_encode_block(raw + done, n, payload, cap, opt->codec, opt->level, tab,
+                                   &codec, &flags, &plen, &h) != 0 ||
+                writer_block(w, codec, flags, entropie_index(h), payload, plen, raw + done, n) != 0) {
+                rc = -1;
+                break;
+            }
+            done += n;
+            TRACE_FIN(t_bloc, "bloc", n);
+        }
+        if (rc != 0 || r < fenetre) break;
+    }
+    if (ferror(in)) rc = -1;
+
+    hf_free(raw);
+    hf_free(payload);
+    hf_free(tab);
+    return rc;
+}
+
+/* Encode un chunk vers le magasin (s'il n'y est pas déjà) et écrit sa référence. */
+static int writer_chunk(ArchiveWriter *w, const HfOptions *opt, const unsigned char *chunk,
+                        size_t n, unsigned char *block, size_t block_cap) {
+    const char *store_dir = opt->store_dir;
+    ChunkKey key;
+    chunk_key(chunk, n, &key);
+
+    uint16_t entropy = 0; /* chunk déjà dans le magasin : pas d'histogramme */
+    if (!store_has(store_dir, &key)) {
+        int codec, flags;
+        size_t plen;
+        double h;
+        if (codec_encode_block(chunk, n, block + HF2_BLOCK_HEADER_SIZE, block_cap - HF2_BLOCK_HEADER_SIZE,
+                               opt->codec, opt->level, NULL, &codec, &flags, &plen, &h) != 0) return -1;
+        entropy = entropie_index(h);
+        /* blocs du magasin sans somme de contrôle : la clé vérifie déjà le contenu */
+        format_block_header(block, 0, codec, flags, (uint32_t) n, (uint32_t) plen, 0);
+        if (store_put(store_dir, &key, block, HF2_BLOCK_HEADER_SIZE + plen) != 0) return -1;
+    }
+    return writer_block(w, HF2_TAG_REF, 0, entropy, key.b, CHUNK_KEY_SIZE, chunk, n);
+}
+
+/* Variante de writer_encode_all pour --store : frontières FastCDC. */
+static int writer_encode_chunks(ArchiveWriter *w, FILE *in, const HfOptions *opt) {
+    if (store_open(opt->store_dir) != 0) return -1;
+
+    size_t buf_cap = 4 * CDC_MAX_SIZE;
+    size_t block_cap = HF2_BLOCK_HEADER_SIZE + codec_bound(CDC_MAX_SIZE) + 16;
+    unsigned char *buf = (unsigned char*) hf_malloc(buf_cap);
+    unsigned char *block = (unsigned char*) hf_malloc(block_cap);
+    if (!buf || !block) {
+        hf_free(buf);
+        hf_free(block);
+        return -1;
+    }
+
+    int rc = 0;
+    size_t len = 0;
+    int eof = 0;
+    while (rc == 0) {
+        if (!eof) {
+            size_t r = fread(buf + len, 1, buf_cap - len, in);
+            len += r;
+            if (len < buf_cap) {
+                if (ferror(in)) rc = -1;
+                eof = 1;
+            }
+        }
+        /* ne couper qu'avec CDC_MAX_SIZE octets d'avance (ou à la fin) : frontières stables */
+        size_t off = 0;
+        while (rc == 0 && off < len && (eof || len - off >= CDC_MAX_SIZE)) {
+            size_t c = cdc_next_chunk(buf + off, len - off);
+            rc = writer_chunk(w, opt, buf + off, c, block, block_cap);
+            off += c;
+        }
+        memmove(buf, buf + off, len - off);
+        len -= off;
+        if (eof) break;
+    }
+
+    hf_free(buf);
+    hf_free(block);
+    return rc;
+}
+
+int archive_compress_stream(FILE *in, FILE *out, const HfOptions *opt) {
+    if (!in || !out) return -1;
+    HfOptions def;
+    if (!opt) {
+        hf_options_defaut(&def);
+        opt = &def;
+    }
+
+    ArchiveWriter w;
+    memset(&w, 0, sizeof(w));
+    w.out = out;
+
+    int rc = writer_header(&w, (opt->store_dir ? HF2_FLAG_STORE : 0) | flags_checksum(opt->checksum));
+    if (rc == 0) rc = opt->store_dir ? writer_encode_chunks(&w, in, opt) : writer_encode_all(&w, in, opt);
+    if (rc == 0) rc = writer_finish(&w);
+    hf_free(w.entries);
+    return rc;
+}
+
+int archive_compress(const char *input_path, const char *output_path, const HfOptions *opt) {
+    if (!input_path || !output_path) return -1;
+    FILE *in = fopen(input_path, "rb");
+    if (!in) return -1;
+    FILE *out = fopen(output_path, "wb");
+    if (!out) {
+        fclose(in);
+        return -1;
+    }
+    int rc = archive_compress_stream(in, out, opt);
+    fclose(in);
+    if (fclose(out) != 0) rc = -1;
+    return rc;
+}
+
+/* ---------- Ajout ---------- */
+
+/* Lit et valide le pied situé en fin de fichier. */
+static int lire_pied(FILE *f, int *flags, uint64_t *footer_pos, uint32_t *block_count,
+                     uint64_t *total_raw, uint64_t *index_offset) {
+    unsigned char h[HF2_FILE_HEADER_SIZE];
+    if (fseeko(f, 0, SEEK_SET) != 0 || fread(h, 1, sizeof(h), f) != sizeof(h)) return -1;
+    if (memcmp(h, HF2_MAGIC, 4) != 0 || h[4] != HF2_VERSION) return -1;
+    *flags = h[5];
+
+    if (fseeko(f, -(off_t) HF2_FOOTER_SIZE, SEEK_END) != 0) return -1;
+    off_t pos = ftello(f);
+    if (pos < (off_t) HF2_FILE_HEADER_SIZE) return -1;
+
+    unsigned char p[HF2_FOOTER_SIZE];
+    if (fread(p, 1, sizeof(p), f) != sizeof(p)) return -1;
+    if (p[0] != HF2_TAG_FOOTER || memcmp(p + 28, HF2_FOOTER_MAGIC, 4) != 0) return -1;
+
+    *footer_pos = (uint64_t) pos;
+    *block_count = get_u32(p + 4);
+    *total_raw = get_u64(p + 8);
+    *index_offset = get_u64(p + 16);
+    if (*index_offset >= *footer_pos) return -1;
+    return 0;
+}
+
+/* Échec d'un ajout : l'archive est ramenée à son état d'avant (octet de
+ * drapeaux, ancien pied à footer_pos, fichier coupé juste après lui). Passe
+ * par un descripteur neuf : le FILE* de l'ajout est fermé, et ce qui restait
+ * dans son tampon ne peut plus être écrit par-dessus.
+ */
+static int restaurer_archive(const char *archive_path, int flags, uint64_t footer_pos,
+                             const unsigned char pied[HF2_FOOTER_SIZE]) {
+    int fd = open(archive_path, O_WRONLY);
+    if (fd < 0) return -1;
+    unsigned char fl = (unsigned char) flags;
+    int rc = (pwrite(fd, &fl, 1, 5) == 1 &&
+              pwrite(fd, pied, HF2_FOOTER_SIZE, (off_t) footer_pos) == (ssize_t) HF2_FOOTER_SIZE &&
+              ftruncate(fd, (off_t) (footer_pos + HF2_FOOTER_SIZE)) == 0) ? 0 : -1;
+    if (close(fd) != 0) rc = -1;
+    return rc;
+}
+
+int archive_append(const char *input_path, const char *archive_path, const HfOptions *opt) {
+    if (!input_path || !archive_path) return -1;
+    HfOptions def;
+    if (!opt) {
+        hf_options_defaut(&def);
+        opt = &def;
+    }
+
+    FILE *in = fopen(input_path, "rb");
+    if (!in) return -1;
+    FILE *f = fopen(archive_path, "r+b");
+    if (!f) {
+        fclose(in);
+        return -1;
+    }
+
+    ArchiveWriter w;
+    memset(&w, 0, sizeof(w));
+    w.out = f;
+
+    uint64_t footer_pos;
+    int flags = 0;
+    int rc = lire_pied(f, &flags, &footer_pos, &w.block_count, &w.total_raw, &w.prev_index);
+    w.file_flags = flags; /* la somme de contrôle suit celle de l'archive, pas opt->checksum */
+
+    /* copie de l'ancien pied, pour le remettre en place si l'ajout échoue */
+    unsigned char pied[HF2_FOOTER_SIZE];
+    if (rc == 0 && (fseeko(f, (off_t) footer_pos, SEEK_SET) != 0 || fread(pied, 1, sizeof(pied), f) != sizeof(pied))) {
+        rc = -1;
+    }
+    const int modifiable = (rc == 0);
+
+    /* une archive à références a besoin de son magasin ; un premier ajout
+     * avec --store marque l'archive (seul l'octet de drapeaux est réécrit) */
+    if (rc == 0 && (flags & HF2_FLAG_STORE) && !opt->store_dir) rc = -1;
+    if (rc == 0 && opt->store_dir && !(flags & HF2_FLAG_STORE)) {
+        w.file_flags = flags | HF2_FLAG_STORE;
+        unsigned char fl = (unsigned char) w.file_flags;
+        if (fseeko(f, 5, SEEK_SET) != 0 || fwrite(&fl, 1, 1, f) != 1) rc = -1;
+    }
+
+    /* les nouveaux blocs écrasent l'ancien pied */
+    if (rc == 0 && fseeko(f, (off_t) footer_pos, SEEK_SET) != 0) rc = -1;
+    w.offset = footer_pos;
+    if (rc == 0) rc = opt->store_dir ? writer_encode_chunks(&w, in, opt) : writer_encode_all(&w, in, opt);
+    if (rc == 0 && w.n > 0) rc = writer_finish(&w);
+    /* rien de nouveau : l'archive reste intacte (l'ancien pied n'a pas été touché) */
+
+    hf_free(w.entries);
+    fclose(in);
+    if (fclose(f) != 0) rc = -1;
+    if (rc != 0 && modifiable) restaurer_archive(archive_path, flags, footer_pos, pied);
+    return rc;
+}
+
+/* ---------- Décodage séquentiel ---------- */
+
+/* Agrandit *buf à au moins need octets (+8 de marge pour les loads 64 bits). */
+static int reserver(unsigned char **buf, size_t *cap, size_t need) {
+    if (need + 8 <= *cap) return 0;
+    size_t nc = need + 8;
+    unsigned char *tmp = (unsigned char*) hf_realloc(*buf, nc);
+    if (!tmp) return -1;
+    *buf = tmp;
+    *cap = nc;
+    return 0;
+}
+
+/* Résout une référence : lit le bloc du chunk dans le magasin, le décode
+ * dans raw et vérifie que son contenu correspond bien à la clé.
+ */
+static int decoder_ref(const char *store_dir, const unsigned char *key_bytes, uint32_t raw_size,
+                       unsigned char **block, size_t *block_cap, unsigned char *raw) {
+    ChunkKey key, verif;
+    memcpy(key.b, key_bytes, CHUNK_KEY_SIZE);
+    size_t len;
+    if (!store_dir || store_get(store_dir, &key, block, block_cap, &len) != 0) return -1;
+    if (len < HF2_BLOCK_HEADER_SIZE) return -1;
+
+    const unsigned char *b = *block;
+    if (get_u32(b + 4) != raw_size || get_u32(b + 8) != len - HF2_BLOCK_HEADER_SIZE) return -1;
+    if (codec_decode_block(b[0], b[1], b + HF2_BLOCK_HEADER_SIZE, len - HF2_BLOCK_HEADER_SIZE,
+                           raw, raw_size, NULL) != 0) return -1;
+    chunk_key(raw, raw_size, &verif);
+    return (memcmp(key.b, verif.b, CHUNK_KEY_SIZE) == 0) ? 0 : -1;
+}
+
+int archive_decompress_stream(FILE *in, FILE *out, const HfOptions *opt) {
+    if (!in || !out) return -1;
+    const char *store_dir = opt ? opt->store_dir : NULL;
+
+    /* HUF1 : décodé au fil du flux, le magic est déjà consommé */
+    unsigned char h[HF2_FOOTER_SIZE];
+    if (fread(h, 1, 4, in) != 4) return -1;
+    if (memcmp(h, "HUF1", 4) == 0) return decompress_stream_huf1(in, out);
+    if (fread(h + 4, 1, HF2_FILE_HEADER_SIZE - 4, in) != HF2_FILE_HEADER_SIZE - 4) return -1;
+    if (memcmp(h, HF2_MAGIC, 4) != 0 || h[4] != HF2_VERSION) return -1;
+    if ((h[5] & HF2_FLAG_STORE) && !store_dir) return -1;
+    const int file_flags = h[5];
+    const size_t hs = block_header_size(file_flags);
+
+    unsigned char *payload = NULL, *raw = NULL, *block = NULL;
+    size_t payload_cap = 0, raw_cap = 0, block_cap = 0;
+    CodecTable *tab = (CodecTable*) hf_malloc(sizeof(CodecTable));
+    uint32_t blocks = 0;
+    uint64_t total = 0;
+    int rc = -1;
+    if (!tab) return -1;
+    codec_table_reset(tab);
+
+    for (;;) {
+        int tag = fgetc(in);
+        if (tag == EOF) break; /* pas de pied : archive tronquée */
+        h[0] = (unsigned char) tag;
+
+        if (tag == HF2_TAG_FOOTER) {
+            if (fread(h + 1, 1, HF2_FOOTER_SIZE - 1, in) != HF2_FOOTER_SIZE - 1) break;
+            if (memcmp(h + 28, HF2_FOOTER_MAGIC, 4) != 0) break;
+            if (get_u32(h + 4) != blocks || get_u64(h + 8) != total) break;
+            rc = 0;
+            break;
+        }
+
+        if (tag == HF2_TAG_INDEX) {
+            /* l'index ne sert pas au décodage séquentiel : on le saute */
+            if (fread(h + 1, 1, HF2_INDEX_HEADER_SIZE - 1, in) != HF2_INDEX_HEADER_SIZE - 1) break;
+            uint32_t n = get_u32(h + 4);
+            unsigned char e[HF2_INDEX_ENTRY_SIZE];
+            uint32_t k = 0;
+            while (k < n && fread(e, 1, sizeof(e), in) == sizeof(e)) k++;
+            if (k != n) break;
+            continue;
+        }
+
+        TRACE_DEBUT(t_bloc);
+        if (fread(h + 1, 1, hs - 1, in) != hs - 1) break;
+        uint32_t raw_size = get_u32(h + 4);
+        uint32_t payload_size = get_u32(h + 8);
+        if (raw_size > HF2_MAX_BLOCK_SIZE || payload_size > HF2_MAX_BLOCK_SIZE) break;
+        if (reserver(&payload, &payload_cap, payload_size) != 0) break;
+        if (reserver(&raw, &raw_cap, raw_size) != 0) break;
+        if (fread(payload, 1, payload_size, in) != payload_size) break;
+        if (tag == HF2_TAG_REF) {
+            if (payload_size != CHUNK_KEY_SIZE || h[1] != 0) break;
+            if (decoder_ref(store_dir, payload, raw_size, &block, &block_cap, raw) != 0) break;
+            codec_table_reset(tab);
+        } else if (codec_decode_block(tag, h[1], payload, payload_size, raw, raw_size, tab) != 0) {
+            break;
+        }
+        if (checksum(file_flags, raw, raw_size) != lire_checksum(file_flags, h)) break;
+        if (raw_size > 0 && fwrite(raw, 1, raw_size, out) != raw_size) break;
+        blocks++;
+        total += raw_size;
+        TRACE_FIN(t_bloc, "bloc", raw_size);
+    }
+
+    hf_free(payload);
+    hf_free(raw);
+    hf_free(block);
+    hf_free(tab);
+    return rc;
+}
+
+/* ---------- Index ---------- */
+
+void archive_free_index(HfIndex *idx) {
+    if (!idx) return;
+    hf_free(idx->entries);
+    idx->entries = NULL;
+    idx->count = 0;
+}
+
+static int lire_index(FILE *f, HfIndex *idx) {
+    if (!f || !idx) return -1;
+    memset(idx, 0, sizeof(*idx));
+
+    uint64_t footer_pos, seg;
+    uint32_t count;
+    if (lire_pied(f, &idx->flags, &footer_pos, &count, &idx->total_raw, &seg) != 0) return -1;
+
+    /* remonter la chaîne des segments (du plus récent au plus ancien) */
+    uint64_t *segs = NULL;
+    size_t nsegs = 0, cap = 0;
+    uint64_t limite = footer_pos;
+    int rc = 0;
+    for (;;) {
+        if (seg < HF2_FILE_HEADER_SIZE || seg >= limite) {
+            rc = -1;
+            break;
+        }
+        if (nsegs == cap) {
+            size_t nc = cap ? cap * 2 : 8;
+            uint64_t *tmp = (uint64_t*) hf_realloc(segs, nc * sizeof(uint64_t));
+            if (!tmp) {
+                rc = -1;
+                break;
+            }
+            segs = tmp;
+            cap = nc;
+        }
+        segs[nsegs++] = seg;
+        unsigned char h[HF2_INDEX_HEADER_SIZE];
+        if (fseeko(f, (off_t) seg, SEEK_SET) != 0 || fread(h, 1, sizeof(h), f) != sizeof(h) ||
+            h[0] != HF2_TAG_INDEX) {
+            rc = -1;
+            break;
+        }
+        uint64_t prev = get_u64(h + 8);
+        if (prev == 0) break;
+        limite = seg;
+        seg = prev;
+    }
+
+    if (rc == 0 && count > 0) {
+        idx->entries = (HfIndexEntry*) hf_malloc((size_t) count * sizeof(HfIndexEntry));
+        if (!idx->entries) rc = -1;
+    }
+
+    /* relire les entrées dans l'ordre du fichier : chaque bloc suit le
+     * précédent et précède le segment d'index qui le liste, sans quoi les
+     * lectures par segment (decode_segment_task) sortiraient des données */
+    const uint64_t hs = block_header_size(idx->flags);
+    uint64_t debut = HF2_FILE_HEADER_SIZE;
+    uint32_t k = 0;
+    for (size_t s = nsegs; rc == 0 && s-- > 0;) {
+        unsigned char h[HF2_INDEX_HEADER_SIZE];
+        if (fseeko(f, (off_t) segs[s], SEEK_SET) != 0 || fread(h, 1, sizeof(h), f) != sizeof(h)) {
+            rc = -1;
+            break;
+        }
+        uint32_t n = get_u32(h + 4);
+        if (n > count - k) {
+            rc = -1;
+            break;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            unsigned char e[HF2_INDEX_ENTRY_SIZE];
+            if (fread(e, 1, sizeof(e), f) != sizeof(e)) {
+                rc = -1;
+                break;
+            }
+            HfIndexEntry *d = &idx->entries[k++];
+            d->offset = get_u64(e);
+            d->raw_size = get_u32(e + 8);
+            d->payload_size = get_u32(e + 12);
+            d->codec = e[16];
+            d->flags = e[17];
+            d->entropy = get_u16(e + 18);
+            if (d->offset < debut || d->offset >= segs[s] || d->raw_size > HF2_MAX_BLOCK_SIZE ||
+                d->payload_size > HF2_MAX_BLOCK_SIZE || segs[s] - d->offset < hs + d->payload_size) {
+                rc = -1;
+                break;
+            }
+            debut = d->offset + hs + d->payload_size;
+        }
+        debut = segs[s] + HF2_INDEX_HEADER_SIZE + (uint64_t) n * HF2_INDEX_ENTRY_SIZE;
+    }
+    if (rc == 0 && k != count) rc = -1;
+
+    hf_free(segs);
+    if (rc != 0) {
+        archive_free_index(idx);
+        return -1;
+    }
+    idx->count = count;
+    return 0;
+}
+
+int archive_read_index(FILE *f, HfIndex *idx) {
+    TRACE_DEBUT(t);
+    int rc = lire_index(f, idx);
+    TRACE_FIN(t, "lecture index", (rc == 0) ? idx->count : 0);
+    return rc;
+}
+
+/* ---------- Encodage parallèle ---------- */
+
+typedef struct EncodeSegment {
+    int fd;
+    uint64_t raw_off;
+    size_t raw_len;
+    size_t block_size;
+    int file_flags;
+    int codec;                /* codec demandé */
+    int level;
+    int split;
+    unsigned char *out;       /* en-têtes + charges utiles des blocs du segment */
+    size_t out_len;
+    HfIndexEntry *entries;    /* offsets relatifs à out */
+    size_t n;
+    int rc;
+} EncodeSegment;
+
+static size_t taille_bloc_moyenne(const HfIndex *idx) {
+    return idx->count ? (size_t) (idx->total_raw / idx->count) : 0;
+}
+
+static void encode_segment_task(void *arg) {
+    EncodeSegment *sg = (EncodeSegment*) arg;
+    TRACE_DEBUT(t_segment);
+    const size_t hs = block_header_size(sg->file_flags);
+    size_t nblocs = blocs_max(sg->raw_len, sg->block_size, sg->codec, sg->split);
+    unsigned char *raw = (unsigned char*) hf_malloc(sg->raw_len);
+    sg->out = (unsigned char*) hf_malloc(codec_bound(sg->raw_len) + nblocs * (hs + 16));
+    sg->entries = (HfIndexEntry*) hf_malloc(nblocs * sizeof(HfIndexEntry));
+    CodecTable *tab = (CodecTable*) hf_malloc(sizeof(CodecTable));
+    sg->rc = (raw && sg->out && sg->entries && tab) ? 0 : -1;
+    codec_table_reset(tab);
+    TRACE_DEBUT(t_lecture);
+    if (sg->rc == 0 && pread(sg->fd, raw, sg->raw_len, (off_t) sg->raw_off) != (ssize_t) sg->raw_len) {
+        sg->rc = -1;
+    }
+    TRACE_FIN(t_lecture, "lecture", sg->raw_len);
+
+    for (size_t done = 0; sg->rc == 0 && done < sg->raw_len;) {
+        TRACE_DEBUT(t_bloc);
+        const unsigned char *p = raw + done;
+        size_t n = longueur_bloc(p, sg->raw_len - done, sg->block_size, sg->codec, sg->split,
+                                 sg->file_flags);
+        unsigned char *h = sg->out + sg->out_len;
+        int codec, flags;
+        size_t plen;
+        double entropie;
+        if (codec_encode_block(p, n, h + hs, codec_bound(n) + 16, sg->codec, sg->level, tab,
+                               &codec, &flags, &plen, &entropie) != 0) {
+            sg->rc = -1;
+            break;
+        }
+        format_block_header(h, sg->file_flags, codec, flags, (uint32_t) n, (uint32_t) plen,
+                            checksum(sg->file_flags, p, n));
+        HfIndexEntry *e = &sg->entries[sg->n++];
+        e->offset = sg->out_len;
+        e->raw_size = (uint32_t) n;
+        e->payload_size = (uint32_t) plen;
+        e->codec = (unsigned char) codec;
+        e->flags = (unsigned char) flags;
+        e->entropy = entropie_index(entropie);
+        sg->out_len += hs + plen;
+        done += n;
+        TRACE_FIN(t_bloc, "bloc", n);
+    }
+    hf_free(raw);
+    hf_free(tab);
+    TRACE_FIN(t_segment, "segment", sg->n);
+}
+
+int archive_compress_pool(const char *input_path, const char *output_path,
+                          const HfOptions *opt, Pool *pool) {
+    if (!input_path || !output_path) return -1;
+    HfOptions def;
+    if (!opt) {
+        hf_options_defaut(&def);
+        opt = &def;
+    }
+    size_t bs = opt->block_size;
+    if (bs == 0 || bs > HF2_MAX_BLOCK_SIZE) return -1;
+    uint64_t seg_bytes = (uint64_t) bs * blocs_par_segment(bs);
+
+    struct stat st;
+    if (!pool || pool_size(pool) < 2 || opt->store_dir || stat(input_path, &st) != 0 ||
+        !S_ISREG(st.st_mode) || (uint64_t) st.st_size <= seg_bytes) {
+        return archive_compress(input_path, output_path, opt);
+    }
+
+    int fd = open(input_path, O_RDONLY);
+    if (fd < 0) return -1;
+    size_t nsegs = (size_t) (((uint64_t) st.st_size + seg_bytes - 1) / seg_bytes);
+    EncodeSegment *segs = (EncodeSegment*) hf_calloc(nsegs, sizeof(EncodeSegment));
+    if (!segs) {
+        close(fd);
+        return -1;
+    }
+
+    PoolGroup g = POOL_GROUP_INIT;
+    int rc = 0;
+    for (size_t i = 0; i < nsegs; ++i) {
+        segs[i].fd = fd;
+        segs[i].raw_off = i * seg_bytes;
+        segs[i].raw_len = (size_t) (((uint64_t) st.st_size - segs[i].raw_off < seg_bytes)
+                                    ? (uint64_t) st.st_size - segs[i].raw_off : seg_bytes);
+        segs[i].block_size = bs;
+        segs[i].file_flags = flags_checksum(opt->checksum);
+        segs[i].codec = opt->codec;
+        segs[i].level = opt->level;
+        segs[i].split = opt->split;
+        if (pool_submit(pool, &g, encode_segment_task, &segs[i]) != 0) encode_segment_task(&segs[i]);
+    }
+    pool_wait(pool, &g);
+    close(fd);
+
+    /* assemblage dans l'ordre : en-tête, segments, index, pied */
+    FILE *out = fopen(output_path, "wb");
+    if (!out) rc = -1;
+    ArchiveWriter w;
+    memset(&w, 0, sizeof(w));
+    w.out = out;
+    if (rc == 0) rc = writer_header(&w, flags_checksum(opt->checksum));
+    for (size_t i = 0; i < nsegs && rc == 0; ++i) {
+        EncodeSegment *sg = &segs[i];
+        if (sg->rc != 0) {
+            rc = -1;
+            break;
+        }
+        for (size_t k = 0; k < sg->n && rc == 0; ++k) {
+            HfIndexEntry e = sg->entries[k];
+            e.offset += w.offset;
+            rc = writer_add_entry(&w, &e);
+        }
+        if (rc == 0) rc = writer_put(&w, sg->out, sg->out_len);
+    }
+    if (rc == 0) rc = writer_finish(&w);
+    if (out && fclose(out) != 0) rc = -1;
+
+    for (size_t i = 0; i < nsegs; ++i) {
+        hf_free(segs[i].out);
+        hf_free(segs[i].entries);
+    }
+    hf_free(segs);
+    hf_free(w.entries);
+    return rc;
+}
+
+/* ---------- Décodage parallèle ---------- */
+
+typedef struct DecodeSegment {
+    int fd_in;
+    const HfOutput *out;      /* NULL : mode test, rien n'est écrit */
+    int file_flags;
+    const HfIndexEntry *index;  /* premier bloc de l'archive (tables reprises) */
+    const HfIndexEntry *e;
+    size_t n;
+    uint64_t raw_off;         /* position de sortie du premier bloc */
+    const char *store_dir;
+    uint32_t bad;             /* blocs invalides (mode test : on continue après une erreur) */
+    int rc;
+} DecodeSegment;
+
+/* Un segment qui commence par un bloc HF_BLOCK_REUSE_TABLE charge la table du
+ * dernier bloc qui la porte, retrouvé par l'index (lecture de sa seule table).
+ */
+static int charger_table_precedente(const DecodeSegment *sg, CodecTable *tab) {
+    const HfIndexEntry *e = sg->e;
+    while (e > sg->index && (e->flags & HF_BLOCK_REUSE_TABLE)) {
+        --e;
+        if (e->codec != HF_CODEC_HUFF) return -1;
+    }
+    if (e->flags & HF_BLOCK_REUSE_TABLE || e->payload_size < HF_TABLE_BYTES) return -1;
+    const size_t hs = block_header_size(sg->file_flags);
+    unsigned char b[HF2_MAX_BLOCK_HEADER_SIZE + HF_TABLE_BYTES];
+    if (pread(sg->fd_in, b, hs + HF_TABLE_BYTES, (off_t) e->offset) != (ssize_t) (hs + HF_TABLE_BYTES)) return -1;
+    if (b[0] != HF_CODEC_HUFF || (b[1] & ~HF_BLOCK_4STREAMS) != 0) return -1;
+    return codec_table_load(tab, b + hs);
+}
+
+static void decode_segment_task(void *arg) {
+    DecodeSegment *sg = (DecodeSegment*) arg;
+    TRACE_DEBUT(t_segment);
+    const HfIndexEntry *first = &sg->e[0], *last = &sg->e[sg->n - 1];
+    const size_t hs = block_header_size(sg->file_flags);
+    size_t span = (size_t) (last->offset + hs + last->payload_size - first->offset);
+    size_t raw_max = 0;
+    for (size_t i = 0; i < sg->n; ++i) {
+        if (sg->e[i].raw_size > raw_max) raw_max = sg->e[i].raw_size;
+    }
+
+    unsigned char *in = (unsigned char*) hf_malloc(span + 8);
+    unsigned char *raw = (unsigned char*) hf_malloc(raw_max + 8);
+    unsigned char *block = NULL;
+    size_t block_cap = 0;
+    CodecTable *tab = (CodecTable*) hf_malloc(sizeof(CodecTable));
+    sg->rc = (in && raw && tab && pread(sg->fd_in, in, span, (off_t) first->offset) == (ssize_t) span) ? 0 : -1;
+    if (tab) codec_table_reset(tab);
+    if (sg->rc == 0 && (first->flags & HF_BLOCK_REUSE_TABLE) && charger_table_precedente(sg, tab) != 0) {
+        sg->rc = -1;
+    }
+
+    if (sg->rc != 0) sg->bad = (uint32_t) sg->n;
+
+    uint64_t pos = sg->raw_off;
+    for (size_t i = 0; i < sg->n && sg->rc == 0; ++i) {
+        TRACE_DEBUT(t_bloc);
+        const HfIndexEntry *e = &sg->e[i];
+        const unsigned char *h = in + (e->offset - first->offset);
+        const unsigned char *payload = h + hs;
+        int r = (h[0] == e->codec && h[1] == e->flags && get_u32(h + 4) == e->raw_size &&
+                 get_u32(h + 8) == e->payload_size) ? 0 : -1;
+        if (r == 0 && e->codec == HF2_TAG_REF) {
+            r = (e->payload_size == CHUNK_KEY_SIZE && e->flags == 0)
+                ? decoder_ref(sg->store_dir, payload, e->raw_size, &block, &block_cap, raw) : -1;
+            codec_table_reset(tab);
+        } else if (r == 0) {
+            r = codec_decode_block(e->codec, e->flags, payload, e->payload_size, raw, e->raw_size, tab);
+        }
+        if (r == 0 && checksum(sg->file_flags, raw, e->raw_size) != lire_checksum(sg->file_flags, h)) r = -1;
+        if (r == 0 && sg->out && e->raw_size > 0 &&
+            output_write(sg->out, pos, raw, e->raw_size) != 0) r = -1;
+        if (r != 0) {
+            sg->bad++;
+            if (sg->out) sg->rc = -1;
+        }
+        pos += e->raw_size;
+        TRACE_FIN(t_bloc, "bloc", e->raw_size);
+    }
+    hf_free(in);
+    hf_free(raw);
+    hf_free(block);
+    hf_free(tab);
+    TRACE_FIN(t_segment, "segment", sg->n);
+}
+
+int archive_decompress_pool(const char *input_path, const char *output_path,
+                            const HfOptions *opt, Pool *pool) {
+    if (!input_path || !output_path) return -1;
+
+    /* L'index donne la taille de sortie : elle est préallouée, puis chaque
+     * segment y écrit ses blocs à leur position (sur le thread appelant quand
+     * il n'y a pas de pool).
+     */
+    FILE *in = fopen(input_path, "rb");
+    if (!in) return -1;
+    HfIndex idx;
+    size_t par_seg = 0;
+    if (archive_read_index(in, &idx) == 0) par_seg = blocs_par_segment(taille_bloc_moyenne(&idx));
+    if (par_seg == 0) {
+        /* HUF1 ou archive sans index valide : chemin séquentiel */
+        if (idx.entries) archive_free_index(&idx);
+        fclose(in);
+        return decompress_file_ex(input_path, output_path, opt);
+    }
+    const char *store_dir = opt ? opt->store_dir : NULL;
+    if ((idx.flags & HF2_FLAG_STORE) && !store_dir) {
+        archive_free_index(&idx);
+        fclose(in);
+        return -1;
+    }
+
+    /* l'index doit couvrir exactement la taille annoncée avant de la réserver */
+    uint64_t total = 0;
+    for (size_t i = 0; i < idx.count; ++i) total += idx.entries[i].raw_size;
+    HfOutput out;
+    out.fd = -1;
+    int rc = (total == idx.total_raw) ? output_open(&out, output_path, idx.total_raw) : -1;
+
+    size_t nsegs = (idx.count + par_seg - 1) / par_seg;
+    DecodeSegment *segs = (rc == 0 && nsegs > 0) ? (DecodeSegment*) hf_calloc(nsegs, sizeof(DecodeSegment)) : NULL;
+    if (nsegs > 0 && !segs) rc = -1;
+
+    if (rc == 0) {
+        PoolGroup g = POOL_GROUP_INIT;
+        uint64_t pos = 0;
+        for (size_t i = 0; i < nsegs; ++i) {
+            DecodeSegment *sg = &segs[i];
+            sg->fd_in = fileno(in);
+            sg->out = &out;
+            sg->file_flags = idx.flags;
+            sg->index = idx.entries;
+            sg->e = &idx.entries[i * par_seg];
+            sg->n = (i + 1 < nsegs) ? par_seg : idx.count - i * par_seg;
+            sg->raw_off = pos;
+            sg->store_dir = store_dir;
+            for (size_t k = 0; k < sg->n; ++k) pos += sg->e[k].raw_size;
+            if (pool_submit(pool, &g, decode_segment_task, sg) != 0) decode_segment_task(sg);
+        }
+        pool_wait(pool, &g);
+        for (size_t i = 0; i < nsegs; ++i) {
+            if (segs[i].rc != 0) rc = -1;
+        }
+    }
+
+    hf_free(segs);
+    if (out.fd >= 0) {
+        if (rc == 0 && output_close(&out) != 0) rc = -1;
+        if (rc != 0) output_abort(&out);
+    }
+    archive_free_index(&idx);
+    fclose(in);
+    return rc;
+}
+
+/* ---------- Mode test ---------- */
+
+int archive_test(const char *input_path, const HfOptions *opt, Pool *pool, uint32_t *bad_blocks) {
+    if (bad_blocks) *bad_blocks = 0;
+    if (!input_path) return -1;
+    FILE *in = fopen(input_path, "rb");
+    if (!in) return -1;
+
+    unsigned char magic[4];
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, HF2_MAGIC, 4) != 0) {
+        /* HUF1 : pas de sommes de contrôle, seul un décodage complet valide le fichier */
+        fclose(in);
+        return decompress_file_ex(input_path, "/dev/null", opt);
+    }
+
+    HfIndex idx;
+    if (archive_read_index(in, &idx) != 0) {
+        fclose(in);
+        return -1;
+    }
+    const char *store_dir = opt ? opt->store_dir : NULL;
+    if ((idx.flags & HF2_FLAG_STORE) && !store_dir) {
+        archive_free_index(&idx);
+        fclose(in);
+        return -1;
+    }
+
+    int rc = 0;
+    size_t par_seg = blocs_par_segment(taille_bloc_moyenne(&idx));
+    size_t nsegs = (idx.count + par_seg - 1) / par_seg;
+    DecodeSegment *segs = (nsegs > 0) ? (DecodeSegment*) hf_calloc(nsegs, sizeof(DecodeSegment)) : NULL;
+    if (nsegs > 0 && !segs) rc = -1;
+
+    if (segs) {
+        PoolGroup g = POOL_GROUP_INIT;
+        uint64_t pos = 0;
+        for (size_t i = 0; i < nsegs; ++i) {
+            DecodeSegment *sg = &segs[i];
+            sg->fd_in = fileno(in);
+            sg->out = NULL;
+            sg->file_flags = idx.flags;
+            sg->index = idx.entries;
+            sg->e = &idx.entries[i * par_seg];
+            sg->n = (i + 1 < nsegs) ? par_seg : idx.count - i * par_seg;
+            sg->raw_off = pos;
+            sg->store_dir = store_dir;
+            for (size_t k = 0; k < sg->n; ++k) pos += sg->e[k].raw_size;
+            if (!pool || pool_submit(pool, &g, decode_segment_task, sg) != 0) decode_segment_task(sg);
+        }
+        if (pool) pool_wait(pool, &g);
+        uint32_t bad = 0;
+        for (size_t i = 0; i < nsegs; ++i) bad += segs[i].bad;
+        if (bad_blocks) *bad_blocks = bad;
+        if (bad > 0 || pos != idx.total_raw) rc = -1;
+    }
+
+    hf_free(segs);
+    archive_free_index(&idx);
+    fclose(in);
+    return rc;
+}
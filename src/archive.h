@@ -0,0 +1,189 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+/*
+ * archive.h
+ *
+ * Conteneur HUF2 : flux de blocs indépendants + index en fin de fichier.
+ * Tous les entiers sont en big-endian (comme l'en-tête HUF1).
+ *
+ *   En-tête fichier (8 octets) : "HUF2" | u8 version | u8 flags | u16 réservé
+ *   Bloc   (12 octets + charge) : u8 codec | u8 flags | u16 réservé
+ *                                 | u32 taille brute | u32 taille charge utile
+ *                                 [| somme de contrôle des données brutes : u32 CRC-32C
+ *                                    ou u64 xxh64, selon les drapeaux du fichier]
+ *   Segment d'index (16 + 20*n) : u8 0xFF | 3 octets 0 | u32 n | u64 segment précédent (0 = aucun)
+ *                                 puis n entrées : u64 offset du bloc | u32 taille brute
+ *                                 | u32 taille charge utile | u8 codec | u8 flags | u16 entropie
+ *   Pied (32 octets)            : u8 0xFE | 3 octets 0 | u32 nombre total de blocs
+ *                                 | u64 taille brute totale | u64 offset du dernier segment d'index
+ *                                 | u32 réservé | "H2FT"
+ *
+ * Ajout (-a) : les nouveaux blocs sont écrits à la place de l'ancien pied,
+ * suivis d'un segment d'index ne listant que ces blocs (chaîné au précédent)
+ * et d'un nouveau pied. Rien d'autre n'est relu ni réécrit : le coût d'un
+ * ajout ne dépend que de la taille des nouvelles données.
+ *
+ * Le premier octet de chaque élément (codec, 0xFD, 0xFF, 0xFE) permet aussi de
+ * décoder l'archive séquentiellement, sans seek (tubes, stdin).
+ *
+ * Drapeaux de bloc : HF_BLOCK_REUSE_TABLE (codec.h), le bloc HF_CODEC_HUFF
+ * reprend la table du bloc précédent. Une suite de reprises ne franchit
+ * jamais une fenêtre d'encodage (blocs_par_segment blocs de block_size) ni un
+ * ajout ; un décodeur qui commence au milieu retrouve la table par l'index.
+ *
+ * Sommes de contrôle (drapeaux HF2_FLAG_CRC32C / HF2_FLAG_XXH64) : chaque
+ * bloc porte la somme de ses données brutes, vérifiée à chaque décodage et
+ * par le mode test (-t), qui décode en mémoire sans rien écrire.
+ *
+ * Entropie (entrée d'index) : entropie d'ordre 0 des données brutes du bloc,
+ * HF2_ENTROPY_KNOWN | round(bits par octet * HF2_ENTROPY_SCALE) ; 0 si
+ * inconnue (archives plus anciennes, chunk déjà présent dans le magasin).
+ * Le mode inspection (-i, inspect.h) la compare au coût réel du bloc sans
+ * rien décoder ; les décodeurs l'ignorent.
+ *
+ * Déduplication (--store DIR, drapeau HF2_FLAG_STORE dans l'en-tête) : l'entrée
+ * est découpée par FastCDC (chunker.h) et chaque chunk devient un bloc
+ * HF2_TAG_REF dont la charge utile est la clé de 16 octets du chunk dans le
+ * magasin (store.h). Seuls les chunks absents du magasin sont encodés.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define HF2_MAGIC              "HUF2"
+#define HF2_VERSION            1
+#define HF2_FILE_HEADER_SIZE   8
+#define HF2_BLOCK_HEADER_SIZE  12
+#define HF2_INDEX_HEADER_SIZE  16
+#define HF2_INDEX_ENTRY_SIZE   20
+#define HF2_FOOTER_SIZE        32
+#define HF2_FOOTER_MAGIC       "H2FT"
+#define HF2_TAG_INDEX          0xFF
+#define HF2_TAG_FOOTER         0xFE
+#define HF2_TAG_REF            0xFD
+
+/* drapeaux de l'en-tête fichier */
+#define HF2_FLAG_STORE         0x01   /* blocs HF2_TAG_REF : magasin de chunks requis */
+#define HF2_FLAG_CRC32C        0x02   /* blocs suivis d'un CRC-32C (4 octets) */
+#define HF2_FLAG_XXH64         0x04   /* blocs suivis d'un xxh64 (8 octets) */
+
+#define HF2_MAX_BLOCK_HEADER_SIZE (HF2_BLOCK_HEADER_SIZE + 8)
+
+/* entropie des entrées d'index (0..8 bits par octet sur 15 bits) */
+#define HF2_ENTROPY_KNOWN      0x8000
+#define HF2_ENTROPY_SCALE      2048
+
+/* valeurs de HfOptions.checksum */
+#define HF_CHECKSUM_NONE       0
+#define HF_CHECKSUM_CRC32C     1
+#define HF_CHECKSUM_XXH64      2
+
+#define HF2_DEFAULT_BLOCK_SIZE (128u * 1024u)
+#define HF2_MAX_BLOCK_SIZE     (64u * 1024u * 1024u)
+
+/* Options de compression */
+typedef struct HfOptions {
+    size_t block_size;     /* taille brute des blocs (octets) */
+    const char *store_dir; /* magasin de chunks (déduplication), NULL = désactivé */
+    int checksum;          /* HF_CHECKSUM_* des nouvelles archives */
+    int codec;             /* codec demandé pour les blocs (HF_CODEC_*, codec.h) */
+    int level;             /* effort LZ77 pour HF_CODEC_LZ (1..9, lz77.h) */
+    int split;             /* 1 : frontières de blocs adaptatives (split.h, codecs
+                              d'ordre 0), 0 : blocs fixes de block_size */
+} HfOptions;
+
+/* Entrée d'index : un bloc de l'archive */
+typedef struct HfIndexEntry {
+    uint64_t offset;          /* position de l'en-tête du bloc dans le fichier */
+    uint32_t raw_size;
+    uint32_t payload_size;
+    unsigned char codec;
+    unsigned char flags;
+    uint16_t entropy;         /* HF2_ENTROPY_KNOWN | entropie, 0 = inconnue */
+} HfIndexEntry;
+
+/* Index complet (tous segments) d'une archive */
+typedef struct HfIndex {
+    int flags;                /* drapeaux de l'en-tête fichier */
+    uint32_t count;
+    uint64_t total_raw;
+    HfIndexEntry *entries;    /* count entrées, dans l'ordre du fichier */
+} HfIndex;
+
+typedef struct Pool Pool;
+
+/* Remplit opt avec les valeurs par défaut. */
+void hf_options_defaut(HfOptions *opt);
+
+/* Niveaux de compression (-1 .. -9) : chacun fixe codec, effort LZ77,
+ * découpage et taille de bloc, du plus rapide au meilleur taux (débits et
+ * taux : make bench BENCH=levels, voir README). Le niveau par défaut est
+ * celui de hf_options_defaut.
+ */
+#define HF_LEVEL_MIN     1
+#define HF_LEVEL_MAX     9
+#define HF_LEVEL_DEFAULT 2
+
+/* Applique le niveau level à opt (les autres champs sont inchangés).
+ * Retourne 0 si OK, -1 si level est hors de HF_LEVEL_MIN..HF_LEVEL_MAX.
+ */
+int hf_options_level(HfOptions *opt, int level);
+
+/* Compresse tout le flux in vers out (écriture séquentielle, pas de seek).
+ * opt peut être NULL (valeurs par défaut). Retourne 0 si OK, -1 si erreur.
+ */
+int archive_compress_stream(FILE *in, FILE *out, const HfOptions *opt);
+
+/* Version fichiers de archive_compress_stream. */
+int archive_compress(const char *input_path, const char *output_path, const HfOptions *opt);
+
+/* Ajoute le contenu de input_path à la fin de l'archive HUF2 archive_path
+ * sans relire ni réencoder les blocs existants. Retourne 0 si OK, -1 si erreur.
+ */
+int archive_append(const char *input_path, const char *archive_path, const HfOptions *opt);
+
+/* Décode séquentiellement une archive HUF2 (en-tête compris) de in vers out.
+ * Un fichier HUF1 est reconnu à son magic et décodé de même (decompress_stream_huf1).
+ * opt->store_dir est requis si l'archive référence un magasin de chunks ;
+ * opt peut être NULL sinon.
+ * Retourne 0 si OK, -1 si format invalide / tronqué ou erreur d'E/S.
+ */
+int archive_decompress_stream(FILE *in, FILE *out, const HfOptions *opt);
+
+/* Lit le pied et tous les segments d'index de l'archive (f doit être seekable).
+ * Retourne 0 si OK (libérer avec archive_free_index), -1 si format invalide.
+ */
+int archive_read_index(FILE *f, HfIndex *idx);
+void archive_free_index(HfIndex *idx);
+
+/* Taille de l'en-tête d'un bloc (somme de contrôle comprise) pour les
+ * drapeaux d'en-tête fichier file_flags ; la charge utile suit.
+ */
+size_t archive_block_header_size(int file_flags);
+
+/* Versions parallèles (pool de threads, voir pool.h) de archive_compress et
+ * decompress_file_ex : un gros fichier est découpé en segments d'environ
+ * 1 Mio (HF2_SEGMENT_BLOCKS blocs de taille par défaut, un seul bloc pour les
+ * gros blocs BWT) encodés / décodés par des tâches distinctes.
+ * À la compression, les petits fichiers et le mode --store retombent sur le
+ * chemin séquentiel. À la décompression, la sortie est préallouée à la taille
+ * donnée par l'index (outfile.h) et chaque bloc décodé y est écrit à sa
+ * position ; seuls HUF1 et les archives sans index valide passent par
+ * decompress_file_ex. pool peut être NULL (tout sur le thread appelant).
+ */
+#define HF2_SEGMENT_BLOCKS 8
+int archive_compress_pool(const char *input_path, const char *output_path,
+                          const HfOptions *opt, Pool *pool);
+int archive_decompress_pool(const char *input_path, const char *output_path,
+                            const HfOptions *opt, Pool *pool);
+
+/* Mode test : décode toute l'archive en mémoire (en parallèle par segments
+ * si pool != NULL) et vérifie les sommes de contrôle, sans rien écrire.
+ * *bad_blocks reçoit le nombre de blocs invalides (peut être NULL).
+ * Retourne 0 si l'archive est intègre, -1 sinon.
+ */
+int archive_test(const char *input_path, const HfOptions *opt, Pool *pool, uint32_t *bad_blocks);
+
+#endif /* ARCHIVE_H */
@@ -0,0 +1,187 @@
+/*
+ * batch.c
+ *
+ * Mode batch (voir batch.h).
+ */
+
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime, getline, stat */
+
+#include "batch.h"
+#include "pool.h"
+#include "alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+typedef struct FileJob {
+    char mode;
+    const char *input;
+    char *output;
+    const HfOptions *opt;
+    Pool *pool;
+    int rc;
+} FileJob;
+
+static pthread_mutex_t report_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e3 + (double) ts.tv_nsec / 1e6;
+}
+
+static long long taille(const char *path) {
+    struct stat st;
+    return (stat(path, &st) == 0) ? (long long) st.st_size : -1;
+}
+
+/* Écrit s en chaîne JSON (guillemets et échappements compris). */
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (const unsigned char *p = (const unsigned char*) s; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', f);
+            fputc(*p, f);
+        } else if (*p < 0x20) {
+            fprintf(f, "\\u%04x", *p);
+        } else {
+            fputc(*p, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static char* nom_sortie(char mode, const char *in) {
+    size_t n = strlen(in);
+    char *out = (char*) malloc(n + 6);
+    if (!out) return NULL;
+    if (mode == 'c') {
+        snprintf(out, n + 6, "%s.huff", in);
+    } else if (n > 5 && strcmp(in + n - 5, ".huff") == 0) {
+        memcpy(out, in, n - 5);
+        out[n - 5] = '\0';
+    } else {
+        snprintf(out, n + 6, "%s.out", in);
+    }
+    return out;
+}
+
+static void file_task(void *arg) {
+    FileJob *job = (FileJob*) arg;
+    HfAllocScope portee;
+    HfAllocStats mem;
+    hf_alloc_scope_begin(&portee);
+    double t0 = now_ms();
+    if (!job->output) {
+        job->rc = -1;
+    } else if (job->mode == 'c') {
+        job->rc = archive_compress_pool(job->input, job->output, job->opt, job->pool);
+    } else {
+        job->rc = archive_decompress_pool(job->input, job->output, job->opt, job->pool);
+    }
+    double ms = now_ms() - t0;
+    hf_alloc_scope_end(&portee, &mem);
+
+    pthread_mutex_lock(&report_mtx);
+    printf("{\"file\":");
+    json_string(stdout, job->input);
+    if (job->output) {
+        printf(",\"output\":");
+        json_string(stdout, job->output);
+    }
+    printf(",\"mode\":\"%s\"", job->mode == 'c' ? "compress" : "decompress");
+    if (job->rc == 0) {
+        printf(",\"status\":\"ok\",\"in_bytes\":%lld,\"out_bytes\":%lld,\"ms\":%.3f",
+               taille(job->input), taille(job->output), ms);
+    } else {
+        printf(",\"status\":\"error\",\"error\":\"%s\",\"ms\":%.3f",
+               job->mode == 'c' ? "compression failed" : "decompression failed", ms);
+    }
+    if (hf_alloc_counting()) {
+        /* --mem-stats : allocations de ce fichier seul, tâches de segments comprises */
+        printf(",\"allocs\":%llu,\"bytes\":%llu,\"peak\":%llu", (unsigned long long) mem.allocations,
+               (unsigned long long) mem.bytes, (unsigned long long) mem.peak);
+    }
+    printf("}\n");
+    fflush(stdout);
+    pthread_mutex_unlock(&report_mtx);
+}
+
+int batch_read_manifest(FILE *f, char ***inputs, char ***outputs) {
+    if (!f || !inputs || !outputs) return -1;
+    char **in = NULL, **out = NULL;
+    int n = 0, cap = 0, lu = 0;
+    char *line = NULL;
+    size_t lcap = 0;
+    ssize_t len;
+
+    while ((len = getline(&line, &lcap, f)) >= 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (len == 0) continue;
+        if (n == cap) {
+            int nc = cap ? cap * 2 : 64;
+            char **ti = (char**) realloc(in, sizeof(char*) * (size_t) nc);
+            if (ti) in = ti;
+            char **to = (char**) realloc(out, sizeof(char*) * (size_t) nc);
+            if (to) out = to;
+            if (!ti || !to) {
+                lu = -1;
+                break;
+            }
+            cap = nc;
+        }
+        char *tab = strchr(line, '\t');
+        if (tab) *tab = '\0';
+        in[n] = strdup(line);
+        out[n] = tab ? strdup(tab + 1) : NULL;
+        if (!in[n] || (tab && !out[n])) {
+            free(in[n]);
+            free(out[n]);
+            lu = -1;
+            break;
+        }
+        n++;
+    }
+    free(line);
+    if (lu < 0) {
+        /* liste partielle : les chaînes déjà copiées sont libérées avec */
+        for (int i = 0; i < n; ++i) {
+            free(in[i]);
+            free(out[i]);
+        }
+        free(in);
+        free(out);
+        return -1;
+    }
+    *inputs = in;
+    *outputs = out;
+    return n;
+}
+
+int batch_run(char mode, char **inputs, char **outputs, int n, const HfOptions *opt, Pool *pool) {
+    if (n <= 0) return 0;
+    FileJob *jobs = (FileJob*) calloc((size_t) n, sizeof(FileJob));
+    if (!jobs) return n;
+
+    PoolGroup g = POOL_GROUP_INIT;
+    for (int i = 0; i < n; ++i) {
+        jobs[i].mode = mode;
+        jobs[i].input = inputs[i];
+        jobs[i].output = (outputs && outputs[i]) ? strdup(outputs[i]) : nom_sortie(mode, inputs[i]);
+        jobs[i].opt = opt;
+        jobs[i].pool = pool;
+        if (pool_submit(pool, &g, file_task, &jobs[i]) != 0) file_task(&jobs[i]);
+    }
+    pool_wait(pool, &g);
+
+    int echecs = 0;
+    for (int i = 0; i < n; ++i) {
+        if (jobs[i].rc != 0) echecs++;
+        free(jobs[i].output);
+    }
+    free(jobs);
+    return echecs;
+}
@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+/*
+ * batch.h
+ *
+ * Mode batch : compresse / décompresse une liste de fichiers en une seule
+ * invocation, sur un pool de threads partagé (pool.h).
+ *
+ * - chaque fichier est une tâche ; les petits fichiers s'empilent sur les
+ *   travailleurs libres, les gros sont en plus découpés en segments
+ *   (archive_compress_pool / archive_decompress_pool) ;
+ * - sortie : "<entrée>.huff" en compression ; en décompression ".huff" est
+ *   retiré (ou ".out" ajouté) ; un manifeste peut donner la sortie explicitement ;
+ * - un résultat JSON par fichier (une ligne) est écrit sur stdout dès qu'il est terminé.
+ */
+
+#include "archive.h"
+
+/* Lit un manifeste (une entrée par ligne : "entrée" ou "entrée<TAB>sortie").
+ * Retourne le nombre d'entrées lues (tableaux alloués dans *inputs / *outputs,
+ * sortie NULL si absente), ou -1 en cas d'erreur.
+ */
+int batch_read_manifest(FILE *f, char ***inputs, char ***outputs);
+
+/* Exécute le batch. mode : 'c' (compression) ou 'd' (décompression).
+ * outputs peut être NULL (noms par défaut). Retourne le nombre de fichiers en échec.
+ */
+int batch_run(char mode, char **inputs, char **outputs, int n, const HfOptions *opt, Pool *pool);
+
+#endif /* BATCH_H */
@@ -0,0 +1,94 @@
+/*
+ * bitkernels.c
+ *
+ * Instanciation des noyaux bit-à-bit (bitkernels_tmpl.h) et choix de la
+ * variante au démarrage.
+ *
+ * Toutes les variantes produisent exactement le même flux de bits ; seule
+ * la sélection d'instructions change. AVX2 n'apporte rien ici : l'écriture
+ * d'un code dépend de la position laissée par le précédent, la boucle est
+ * donc sérielle et c'est BMI2 (masques et décalages variables sans
+ * dépendance sur les flags) qui raccourcit la chaîne critique.
+ */
+
+#include "bitkernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BK_HAVE_BMI2 1
+#include <immintrin.h>
+#else
+#define BK_HAVE_BMI2 0
+#endif
+
+/* ---------- Variante scalaire (portable) ---------- */
+
+#define BK_SUFFIX scalar
+#define BK_ATTR
+#define BK_MASK(v, n) ((uint64_t) (v) & ((1ULL << (n)) - 1ULL))
+#include "bitkernels_tmpl.h"
+#undef BK_SUFFIX
+#undef BK_ATTR
+#undef BK_MASK
+
+static const BitKernels kernels_scalar = {
+    "scalar", encode_scalar, decode_tree_scalar
+};
+
+/* ---------- Variante BMI2 ---------- */
+
+#if BK_HAVE_BMI2
+#define BK_SUFFIX bmi2
+#define BK_ATTR __attribute__((target("bmi2")))
+#define BK_MASK(v, n) _bzhi_u64((uint64_t) (v), (n))
+#include "bitkernels_tmpl.h"
+#undef BK_SUFFIX
+#undef BK_ATTR
+#undef BK_MASK
+
+static const BitKernels kernels_bmi2 = {
+    "bmi2", encode_bmi2, decode_tree_bmi2
+};
+
+static int cpu_has_bmi2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+}
+#endif
+
+/* ---------- Dispatch ---------- */
+
+static const BitKernels *active_kernels = NULL;
+
+const BitKernels* bit_kernels_by_name(const char *name) {
+    if (!name) return NULL;
+    if (strcmp(name, "scalar") == 0) return &kernels_scalar;
+#if BK_HAVE_BMI2
+    if (strcmp(name, "bmi2") == 0) return cpu_has_bmi2() ? &kernels_bmi2 : NULL;
+#endif
+    return NULL;
+}
+
+void bit_kernels_init(void) {
+    if (active_kernels) return;
+
+    const char *forced = getenv("HUFFMAN_KERNEL");
+    if (forced) {
+        const BitKernels *k = bit_kernels_by_name(forced);
+        if (k) {
+            active_kernels = k;
+            return;
+        }
+    }
+
+    active_kernels = &kernels_scalar;
+#if BK_HAVE_BMI2
+    if (cpu_has_bmi2()) active_kernels = &kernels_bmi2;
+#endif
+}
+
+const BitKernels* bit_kernels(void) {
+    if (!active_kernels) bit_kernels_init();
+    return active_kernels;
+}
@@ -0,0 +1,68 @@
+#ifndef BITKERNELS_H
+#define BITKERNELS_H
+
+/*
+ * bitkernels.h
+ *
+ * Noyaux d'E/S bit-à-bit par mots de 64 bits (encodage d'octets avec une
+ * table de codes, décodage par parcours d'arbre).
+ *
+ * Plusieurs variantes existent :
+ * - "scalar" : C portable, toujours disponible ;
+ * - "bmi2"   : même algorithme compilé pour BMI2 (bzhi, shlx/shrx), x86-64 seulement.
+ *
+ * La variante est choisie une seule fois au démarrage (cpuid) par
+ * bit_kernels_init(). La variable d'environnement HUFFMAN_KERNEL=scalar|bmi2
+ * permet de forcer une variante (comparaison des sorties, mesures).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "io.h"
+#include "huffman.h"
+
+/* Load / store big-endian non alignés (memcpy -> une seule instruction mov + bswap). */
+static inline uint64_t bk_load_be64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline void bk_store_be64(unsigned char *p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, 8);
+}
+
+typedef struct BitKernels {
+    const char *name;
+
+    /* Encode n octets de src : pour chaque octet x, écrit les lens[x] bits de
+     * poids faible de codes[x] (MSB en premier). Chaque symbole présent dans
+     * src doit avoir 1 <= lens[x] <= 32. Retourne 0 si OK, -1 si erreur d'écriture.
+     */
+    int (*encode)(BitWriter *bw, const unsigned char *src, size_t n,
+                  const uint32_t codes[256], const unsigned char lens[256]);
+
+    /* Décode n symboles en suivant l'arbre (gauche=0, droite=1) et les écrit
+     * dans dst. Retourne 0 si OK, -1 si le flux est tronqué.
+     */
+    int (*decode_tree)(BitReader *br, const Noeud *root, unsigned char *dst, size_t n);
+} BitKernels;
+
+/* Sélectionne la meilleure variante pour le CPU courant (idempotent). */
+void bit_kernels_init(void);
+
+/* Variante active (appelle bit_kernels_init() si nécessaire). */
+const BitKernels* bit_kernels(void);
+
+/* Variante par nom ("scalar", "bmi2") ; NULL si inconnue ou non supportée par le CPU. */
+const BitKernels* bit_kernels_by_name(const char *name);
+
+#endif /* BITKERNELS_H */
@@ -0,0 +1,100 @@
+/*
+ * bitkernels_tmpl.h
+ *
+ * Corps des noyaux bit-à-bit. Ce fichier n'a pas de garde d'inclusion :
+ * bitkernels.c l'inclut une fois par variante après avoir défini
+ *   BK_SUFFIX       suffixe des fonctions générées (scalar, bmi2, ...)
+ *   BK_ATTR         attributs de la variante (ex: __attribute__((target("bmi2"))))
+ *   BK_MASK(v, n)   les n bits de poids faible de v (n = 1..32)
+ */
+
+#define BK_CAT_(a, b) a##_##b
+#define BK_CAT(a, b)  BK_CAT_(a, b)
+#define BK_NAME(x)    BK_CAT(x, BK_SUFFIX)
+
+/* Encodage : acc contient les bits en attente alignés sur le MSB.
+ * Chaque symbole fait un store 64 bits inconditionnel puis avance le
+ * pointeur de cnt/8 octets : aucune boucle ni branche par octet émis.
+ */
+BK_ATTR static int BK_NAME(encode)(BitWriter *bw, const unsigned char *src, size_t n,
+                                   const uint32_t codes[256], const unsigned char lens[256]) {
+    uint64_t acc = bw->acc;
+    unsigned int cnt = (unsigned int) bw->bit_count;
+    unsigned char *p = bw->buf + bw->len;
+    unsigned char *lim = bw->buf + bw->cap;
+
+    for (size_t i = 0; i < n; ++i) {
+        unsigned int l = lens[src[i]];
+        acc |= (uint64_t) BK_MASK(codes[src[i]], l) << (64 - cnt - l);
+        cnt += l;
+        bk_store_be64(p, acc);
+        unsigned int nbytes = cnt >> 3;   /* 0..4 */
+        p += nbytes;
+        acc <<= (nbytes << 3);
+        cnt &= 7;
+        if (p >= lim) {
+            bw->len = (size_t) (p - bw->buf);
+            if (bw_drain(bw) != 0) return -1;
+            p = bw->buf + bw->len;
+        }
+    }
+
+    bw->acc = acc;
+    bw->bit_count = (int) cnt;
+    bw->len = (size_t) (p - bw->buf);
+    return 0;
+}
+
+/* Décodage : une fenêtre de 57+ bits est chargée par symbole (load 64 bits
+ * non aligné), puis l'arbre est parcouru en consommant les bits de la fenêtre.
+ * Les codes plus longs que 56 bits (arbres HUF1 dégénérés) rechargent la
+ * fenêtre en cours de symbole.
+ */
+BK_ATTR static int BK_NAME(decode_tree)(BitReader *br, const Noeud *root, unsigned char *dst, size_t n) {
+    size_t pos = br->bit_pos;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!br->eof && pos + 128 > (br->len << 3)) {
+            br->bit_pos = pos;
+            if (br_refill(br) != 0) return -1;
+            pos = br->bit_pos;
+        }
+        if (pos >= (br->len << 3)) return -1; /* flux tronqué */
+
+        uint64_t w = bk_load_be64(br->buf + (pos >> 3)) << (pos & 7);
+        const Noeud *node = root;
+        unsigned int used = 0;
+
+        if (node->leaf) {
+            /* arbre à une seule feuille : un bit "0" par symbole */
+            used = 1;
+        } else {
+            do {
+                node = (w >> 63) ? node->right : node->left;
+                w <<= 1;
+                if (++used == 56 && !node->leaf) {
+                    pos += used;
+                    used = 0;
+                    if (!br->eof && pos + 128 > (br->len << 3)) {
+                        br->bit_pos = pos;
+                        if (br_refill(br) != 0) return -1;
+                        pos = br->bit_pos;
+                    }
+                    if (pos >= (br->len << 3)) return -1;
+                    w = bk_load_be64(br->buf + (pos >> 3)) << (pos & 7);
+                }
+            } while (!node->leaf);
+        }
+
+        pos += used;
+        if (pos > (br->len << 3)) return -1; /* bits de marge consommés : tronqué */
+        dst[i] = (unsigned char) node->c;
+    }
+
+    br->bit_pos = pos;
+    return 0;
+}
+
+#undef BK_NAME
+#undef BK_CAT
+#undef BK_CAT_
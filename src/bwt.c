@@ -0,0 +1,199 @@
+/*
+ * bwt.c
+ *
+ * - tableau des suffixes par SA-IS (Nong, Zhang & Chan, 2009) : tri induit
+ *   des sous-chaînes LMS, récursion sur la chaîne réduite, temps O(n) ;
+ * - inverse "tt" (comme bzip2) : le lien vers la ligne suivante et l'octet de
+ *   la colonne L sont rangés dans le même mot de 32 bits, ce qui ne coûte
+ *   qu'un accès mémoire aléatoire par octet produit.
+ */
+
+#include "bwt.h"
+#include "alloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------- SA-IS ---------- */
+
+/* t[i] = 1 si le suffixe i est de type S, 0 s'il est de type L */
+#define EST_LMS(t, i) ((i) > 0 && (t)[i] && !(t)[(i) - 1])
+
+/* Bornes des compartiments : début (fin == 0) ou fin (fin == 1) de chaque symbole. */
+static void compartiments(const int32_t *s, int32_t n, int32_t k, int32_t *bkt, int fin) {
+    memset(bkt, 0, (size_t) (k + 1) * sizeof(int32_t));
+    for (int32_t i = 0; i < n; ++i) bkt[s[i]]++;
+    int32_t somme = 0;
+    for (int32_t c = 0; c <= k; ++c) {
+        somme += bkt[c];
+        bkt[c] = fin ? somme : somme - bkt[c];
+    }
+}
+
+static void induire_l(const unsigned char *t, int32_t *sa, const int32_t *s, int32_t *bkt,
+                      int32_t n, int32_t k) {
+    compartiments(s, n, k, bkt, 0);
+    for (int32_t i = 0; i < n; ++i) {
+        int32_t j = sa[i] - 1;
+        if (j >= 0 && !t[j]) sa[bkt[s[j]]++] = j;
+    }
+}
+
+static void induire_s(const unsigned char *t, int32_t *sa, const int32_t *s, int32_t *bkt,
+                      int32_t n, int32_t k) {
+    compartiments(s, n, k, bkt, 1);
+    for (int32_t i = n - 1; i >= 0; --i) {
+        int32_t j = sa[i] - 1;
+        if (j >= 0 && t[j]) sa[--bkt[s[j]]] = j;
+    }
+}
+
+/* s[0..n) sur l'alphabet 0..k, s[n-1] == 0 unique (sentinelle), n >= 2.
+ * Retourne 0 si OK, -1 en cas d'échec d'allocation.
+ */
+static int sais(const int32_t *s, int32_t *sa, int32_t n, int32_t k) {
+    unsigned char *t = (unsigned char*) hf_malloc((size_t) n);
+    int32_t *bkt = (int32_t*) hf_malloc((size_t) (k + 1) * sizeof(int32_t));
+    if (!t || !bkt) {
+        hf_free(t);
+        hf_free(bkt);
+        return -1;
+    }
+
+    t[n - 1] = 1;
+    t[n - 2] = 0;
+    for (int32_t i = n - 3; i >= 0; --i) {
+        t[i] = (s[i] < s[i + 1] || (s[i] == s[i + 1] && t[i + 1])) ? 1 : 0;
+    }
+
+    /* étape 1 : tri induit des sous-chaînes LMS */
+    compartiments(s, n, k, bkt, 1);
+    for (int32_t i = 0; i < n; ++i) sa[i] = -1;
+    for (int32_t i = 1; i < n; ++i) {
+        if (EST_LMS(t, i)) sa[--bkt[s[i]]] = i;
+    }
+    induire_l(t, sa, s, bkt, n, k);
+    induire_s(t, sa, s, bkt, n, k);
+
+    /* regrouper les LMS triées au début de sa, puis les nommer */
+    int32_t n1 = 0;
+    for (int32_t i = 0; i < n; ++i) {
+        if (EST_LMS(t, sa[i])) sa[n1++] = sa[i];
+    }
+    for (int32_t i = n1; i < n; ++i) sa[i] = -1;
+    int32_t nom = 0, prec = -1;
+    for (int32_t i = 0; i < n1; ++i) {
+        int32_t pos = sa[i];
+        int diff = 0;
+        for (int32_t d = 0; d < n; ++d) {
+            if (prec == -1 || s[pos + d] != s[prec + d] || t[pos + d] != t[prec + d]) {
+                diff = 1;
+                break;
+            } else if (d > 0 && (EST_LMS(t, pos + d) || EST_LMS(t, prec + d))) {
+                break;
+            }
+        }
+        if (diff) {
+            nom++;
+            prec = pos;
+        }
+        sa[n1 + pos / 2] = nom - 1;
+    }
+    for (int32_t i = n - 1, j = n - 1; i >= n1; --i) {
+        if (sa[i] >= 0) sa[j--] = sa[i];
+    }
+
+    /* étape 2 : trier la chaîne réduite (récursion si des noms se répètent) */
+    int32_t *sa1 = sa, *s1 = sa + n - n1;
+    int rc = 0;
+    if (nom < n1) {
+        rc = sais(s1, sa1, n1, nom - 1);
+    } else {
+        for (int32_t i = 0; i < n1; ++i) sa1[s1[i]] = i;
+    }
+
+    /* étape 3 : placer les LMS dans l'ordre final puis induire le reste */
+    if (rc == 0) {
+        compartiments(s, n, k, bkt, 1);
+        for (int32_t i = 1, j = 0; i < n; ++i) {
+            if (EST_LMS(t, i)) s1[j++] = i;
+        }
+        for (int32_t i = 0; i < n1; ++i) sa1[i] = s1[sa1[i]];
+        for (int32_t i = n1; i < n; ++i) sa[i] = -1;
+        for (int32_t i = n1 - 1; i >= 0; --i) {
+            int32_t j = sa[i];
+            sa[i] = -1;
+            sa[--bkt[s[j]]] = j;
+        }
+        induire_l(t, sa, s, bkt, n, k);
+        induire_s(t, sa, s, bkt, n, k);
+    }
+
+    hf_free(t);
+    hf_free(bkt);
+    return rc;
+}
+
+/* ---------- Transformée ---------- */
+
+int bwt_forward(const unsigned char *src, size_t n, unsigned char *dst, uint32_t *primary) {
+    if (!src || !dst || !primary || n == 0 || n > BWT_MAX_SIZE) return -1;
+
+    /* octets décalés de 1 : 0 est réservé au sentinelle */
+    int32_t m = (int32_t) n + 1;
+    int32_t *s = (int32_t*) hf_malloc((size_t) m * sizeof(int32_t));
+    int32_t *sa = (int32_t*) hf_malloc((size_t) m * sizeof(int32_t));
+    if (!s || !sa) {
+        hf_free(s);
+        hf_free(sa);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) s[i] = (int32_t) src[i] + 1;
+    s[n] = 0;
+
+    int rc = sais(s, sa, m, 256);
+    if (rc == 0) {
+        /* sa[0] == n (sentinelle seul) ; la ligne du suffixe 0 porte le sentinelle en L */
+        size_t o = 0;
+        for (int32_t i = 0; i < m; ++i) {
+            if (sa[i] == 0) {
+                *primary = (uint32_t) i;
+            } else {
+                dst[o++] = src[sa[i] - 1];
+            }
+        }
+    }
+    hf_free(s);
+    hf_free(sa);
+    return rc;
+}
+
+int bwt_inverse(const unsigned char *L, size_t n, uint32_t primary, unsigned char *dst) {
+    if (!L || !dst || n == 0 || n > BWT_MAX_SIZE || primary == 0 || primary > n) return -1;
+
+    /* tt[i] = octet L de la ligne i | (ligne suivante dans le texte) << 8 */
+    uint32_t *tt = (uint32_t*) hf_calloc(n + 1, sizeof(uint32_t));
+    if (!tt) return -1;
+
+    uint32_t cumul[257];
+    memset(cumul, 0, sizeof(cumul));
+    for (size_t i = 0; i < n; ++i) cumul[L[i] + 1]++;
+    cumul[0] = 1; /* la ligne 0 de F est le sentinelle */
+    for (int c = 1; c <= 256; ++c) cumul[c] += cumul[c - 1];
+
+    /* lignes de L : indices 0..n, le sentinelle s'insère à primary */
+    for (uint32_t i = 0, o = 0; i <= n; ++i) {
+        if (i == primary) continue;
+        unsigned char c = L[o++];
+        tt[i] |= c;
+        tt[cumul[c]++] |= i << 8;
+    }
+
+    uint32_t p = tt[primary] >> 8;
+    for (size_t k = 0; k < n; ++k) {
+        uint32_t e = tt[p];
+        dst[k] = (unsigned char) e;
+        p = e >> 8;
+    }
+    hf_free(tt);
+    return 0;
+}
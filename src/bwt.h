@@ -0,0 +1,34 @@
+#ifndef BWT_H
+#define BWT_H
+
+/*
+ * bwt.h
+ *
+ * Transformée de Burrows-Wheeler d'un bloc en mémoire.
+ *
+ * Le bloc est trié comme s'il était suivi d'un sentinelle unique plus petit
+ * que tout octet (tableau des suffixes SA-IS, temps linéaire) : la colonne L
+ * a n + 1 entrées dont une, à l'indice primary, est le sentinelle. Seuls les
+ * n octets restants sont produits ; primary suffit pour inverser.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Taille maximale d'un bloc : l'inverse range un lien sur 24 bits par octet. */
+#define BWT_MAX_SIZE ((1u << 24) - 2)
+
+/* Calcule la colonne L de src[0..n) (sentinelle omis) dans dst (n octets)
+ * et l'indice du sentinelle dans *primary (1..n).
+ * Retourne 0 si OK, -1 si n est hors limites (0 ou > BWT_MAX_SIZE) ou en cas
+ * d'échec d'allocation.
+ */
+int bwt_forward(const unsigned char *src, size_t n, unsigned char *dst, uint32_t *primary);
+
+/* Inverse : reconstruit dst[0..n) à partir de L[0..n) et primary.
+ * L et dst peuvent désigner le même tampon.
+ * Retourne 0 si OK, -1 si primary est invalide ou en cas d'échec d'allocation.
+ */
+int bwt_inverse(const unsigned char *L, size_t n, uint32_t primary, unsigned char *dst);
+
+#endif /* BWT_H */
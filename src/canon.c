@@ -0,0 +1,85 @@
+/*
+ * canon.c
+ *
+ * Décodeur canonique compact (voir canon.h).
+ */
+
+#include "canon.h"
+#include <string.h>
+
+int canon_init(HfCanon *c, const unsigned char lens[256]) {
+    if (!c || !lens) return -1;
+    memset(c->count, 0, sizeof(c->count));
+    for (int s = 0; s < 256; ++s) {
+        if (lens[s] > HF_MAX_CODE_LEN) return -1;
+        c->count[lens[s]]++;
+    }
+    c->count[0] = 0;
+
+    /* code préfixe : pas plus de codes que l'arbre ne peut en contenir */
+    uint32_t kraft = 0, presents = 0;
+    for (int l = 1; l <= HF_MAX_CODE_LEN; ++l) {
+        kraft += (uint32_t) c->count[l] << (HF_MAX_CODE_LEN - l);
+        presents += c->count[l];
+    }
+    if (presents == 0 || kraft > (1u << HF_MAX_CODE_LEN)) return -1;
+    c->min_len = 1;
+    while (c->count[c->min_len] == 0) c->min_len++;
+
+    /* symboles rangés par longueur, puis par valeur (ordre de codes_canoniques) */
+    uint16_t debut[HF_MAX_CODE_LEN + 1];
+    debut[1] = 0;
+    for (int l = 1; l < HF_MAX_CODE_LEN; ++l) debut[l + 1] = (uint16_t) (debut[l] + c->count[l]);
+    for (int s = 0; s < 256; ++s) {
+        if (lens[s]) c->symbols[debut[lens[s]]++] = (unsigned char) s;
+    }
+    canon_start(c);
+    return 0;
+}
+
+void canon_start(HfCanon *c) {
+    c->bitbuf = 0;
+    c->bitcount = 0;
+}
+
+size_t canon_decode(HfCanon *c, const unsigned char *in, size_t in_len, size_t *consumed,
+                    unsigned char *out, size_t n) {
+    uint64_t buf = c->bitbuf;
+    int nb = c->bitcount;
+    size_t i = 0, o = 0;
+    size_t rc = 0;
+
+    while (o < n) {
+        if (nb < HF_MAX_CODE_LEN) {
+            while (nb <= 56 && i < in_len) {
+                buf |= (uint64_t) in[i++] << (56 - nb);
+                nb += 8;
+            }
+        }
+        /* code : les l premiers bits ; premier : premier code de longueur l ;
+         * rang : symboles des longueurs plus courtes. Rien ne précède min_len :
+         * son premier code est 0. */
+        int l = c->min_len;
+        if (l > nb) break; /* code coupé : attendre la suite de l'entrée */
+        uint32_t code = (uint32_t) (buf >> (64 - l)), premier = 0, rang = 0;
+        while (code - premier >= c->count[l]) {
+            rang += c->count[l];
+            premier = (premier + c->count[l]) << 1;
+            if (++l > HF_MAX_CODE_LEN || l > nb) break;
+            code = (code << 1) | (uint32_t) ((buf >> (64 - l)) & 1);
+        }
+        if (l > HF_MAX_CODE_LEN) {
+            rc = (size_t) -1;
+            break;
+        }
+        if (l > nb) break;
+        out[o++] = c->symbols[rang + code - premier];
+        buf <<= l;
+        nb -= l;
+    }
+
+    c->bitbuf = buf;
+    c->bitcount = (unsigned char) nb;
+    if (consumed) *consumed = i;
+    return (rc == 0) ? o : rc;
+}
@@ -0,0 +1,54 @@
+#ifndef CANON_H
+#define CANON_H
+
+/*
+ * canon.h
+ *
+ * Décodeur canonique compact pour les flux HF_CODEC_HUFF (codec.h) : toute
+ * la table tient dans le nombre de codes de chaque longueur et la liste des
+ * symboles triés par (longueur, valeur), soit moins de 300 octets avec le
+ * tampon de bits, contre 16 Kio de table directe (CodecTable) ou un arbre de
+ * Noeud alloués. Fait pour garder des milliers de flux ouverts à la fois.
+ *
+ * Le décodage suit le code bit par bit, longueur après longueur (comme puff) :
+ * le code de longueur l est valide s'il est inférieur au premier code de
+ * cette longueur plus count[l]. Plus lent que les tables directes, mais sans
+ * rien à construire ni à allouer.
+ *
+ * Le décodage reprend là où il s'est arrêté : un code coupé en fin d'entrée
+ * reste dans le tampon de bits jusqu'au prochain appel.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "codec.h"
+
+typedef struct HfCanon {
+    uint64_t bitbuf;                        /* bits en attente, alignés sur le MSB */
+    uint16_t count[HF_MAX_CODE_LEN + 1];    /* codes de chaque longueur (count[0] inutilisé) */
+    unsigned char symbols[256];             /* symboles par longueur puis valeur croissantes */
+    unsigned char bitcount;                 /* bits valides dans bitbuf */
+    unsigned char min_len;                  /* plus courte longueur de code */
+} HfCanon;
+
+_Static_assert(sizeof(HfCanon) < 300, "HfCanon doit rester sous 300 octets");
+
+/* Prépare le décodeur pour les longueurs de code lens (0 = symbole absent,
+ * au plus HF_MAX_CODE_LEN) et vide le tampon de bits.
+ * Retourne 0 si OK, -1 si les longueurs ne forment pas un code préfixe.
+ */
+int canon_init(HfCanon *c, const unsigned char lens[256]);
+
+/* Début d'un nouveau flux avec la même table : vide le tampon de bits. */
+void canon_start(HfCanon *c);
+
+/* Décode au plus n symboles de in[0..in_len) vers out. *consumed reçoit le
+ * nombre d'octets lus dans in (ils sont tous dans le tampon ou décodés).
+ * S'arrête après n symboles ou quand l'entrée ne contient plus de code
+ * complet. Retourne le nombre de symboles produits, ou (size_t) -1 si un
+ * code n'existe pas (flux corrompu).
+ */
+size_t canon_decode(HfCanon *c, const unsigned char *in, size_t in_len, size_t *consumed,
+                    unsigned char *out, size_t n);
+
+#endif /* CANON_H */
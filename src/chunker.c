@@ -0,0 +1,53 @@
+/*
+ * chunker.c
+ *
+ * FastCDC (Xia et al., 2016) avec normalisation de la taille des chunks :
+ * - aucun point de coupe avant CDC_MIN_SIZE,
+ * - masque "strict" (plus de bits) jusqu'à CDC_AVG_SIZE,
+ * - masque "lâche" ensuite, coupe forcée à CDC_MAX_SIZE.
+ * Le hachage gear ne coûte qu'un décalage, une addition et un accès table par octet.
+ */
+
+#include "chunker.h"
+#include <stdint.h>
+#include <pthread.h>
+
+/* 16 KiB de moyenne = 14 bits ; normalisation de niveau 2 (+/- 2 bits) */
+#define CDC_MASK_S 0x0003d90703530000ULL   /* 16 bits à 1 */
+#define CDC_MASK_L 0x0000d90103530000ULL   /* 12 bits à 1 */
+
+static uint64_t gear[256];
+static pthread_once_t gear_once = PTHREAD_ONCE_INIT;
+
+/* Table gear déterministe (splitmix64) : les frontières ne dépendent que des données.
+ * Remplie une seule fois (pthread_once) : les tâches --batch découpent en parallèle. */
+static void init_gear(void) {
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 256; ++i) {
+        x += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        gear[i] = z ^ (z >> 31);
+    }
+}
+
+size_t cdc_next_chunk(const unsigned char *p, size_t n) {
+    if (n <= CDC_MIN_SIZE) return n;
+    pthread_once(&gear_once, init_gear);
+
+    size_t max = (n < CDC_MAX_SIZE) ? n : CDC_MAX_SIZE;
+    size_t avg = (max < CDC_AVG_SIZE) ? max : CDC_AVG_SIZE;
+    uint64_t h = 0;
+    size_t i = CDC_MIN_SIZE;
+
+    for (; i < avg; ++i) {
+        h = (h << 1) + gear[p[i]];
+        if (!(h & CDC_MASK_S)) return i + 1;
+    }
+    for (; i < max; ++i) {
+        h = (h << 1) + gear[p[i]];
+        if (!(h & CDC_MASK_L)) return i + 1;
+    }
+    return max;
+}
@@ -0,0 +1,25 @@
+#ifndef CHUNKER_H
+#define CHUNKER_H
+
+/*
+ * chunker.h
+ *
+ * Découpage des données en chunks définis par le contenu (FastCDC, hachage
+ * "gear" glissant). Une insertion ou une suppression au milieu d'un fichier
+ * ne déplace que les frontières voisines : les autres chunks restent
+ * identiques d'une révision à l'autre et peuvent être dédupliqués.
+ */
+
+#include <stddef.h>
+
+#define CDC_MIN_SIZE  (4u * 1024u)
+#define CDC_AVG_SIZE  (16u * 1024u)
+#define CDC_MAX_SIZE  (64u * 1024u)
+
+/* Retourne la longueur du prochain chunk commençant en p (1..min(n, CDC_MAX_SIZE)).
+ * Si n <= CDC_MIN_SIZE, retourne n. L'appelant qui n'a pas encore tout lu doit
+ * fournir au moins CDC_MAX_SIZE octets pour obtenir une frontière stable.
+ */
+size_t cdc_next_chunk(const unsigned char *p, size_t n);
+
+#endif /* CHUNKER_H */
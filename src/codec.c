@@ -0,0 +1,1055 @@
+/*
+ * codec.c
+ *
+ * Encodage / décodage d'un bloc en mémoire :
+ * - histogramme du bloc,
+ * - arbre Huffman (construire_arbre_huffman) -> longueurs limitées -> codes canoniques,
+ * - écriture du flux via les noyaux bit-à-bit (bitkernels.h),
+ * - décodage par table de correspondance indexée par les HF_MAX_CODE_LEN
+ *   prochains bits (un accès mémoire par symbole au lieu d'un par bit),
+ * - mode paires : alphabet de 256 octets + paires d'octets fréquentes, chaque
+ *   entrée de la table de décodage portant directement les octets produits,
+ * - mode LZ : séquences LZ77 (lz77.c) codées comme dans deflate (alphabet
+ *   littéral/longueur + alphabet de distance, bits supplémentaires),
+ * - mode BWT : transformée de Burrows-Wheeler (bwt.c), move-to-front et
+ *   codage des suites de zéros (RUNA/RUNB, comme bzip2), puis Huffman.
+ */
+
+#include "codec.h"
+#include "huffman.h"
+#include "io.h"
+#include "bitkernels.h"
+#include "lz77.h"
+#include "bwt.h"
+#include "canon.h"
+#include "alloc.h"
+#include "trace.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------- Outils ---------- */
+
+/* Histogramme sur 4 tables entrelacées : évite que deux octets identiques
+ * consécutifs se sérialisent sur le même compteur.
+ */
+static void histogramme(const unsigned char *src, size_t n, unsigned long freq[256]) {
+    uint32_t t[4][256];
+    memset(t, 0, sizeof(t));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        t[0][src[i]]++;
+        t[1][src[i + 1]]++;
+        t[2][src[i + 2]]++;
+        t[3][src[i + 3]]++;
+    }
+    for (; i < n; ++i) t[0][src[i]]++;
+    for (int s = 0; s < 256; ++s) {
+        freq[s] = (unsigned long) t[0][s] + t[1][s] + t[2][s] + t[3][s];
+    }
+}
+
+static void ecrire_longueurs(unsigned char *dst, const unsigned char lens[256]) {
+    for (int i = 0; i < HF_TABLE_BYTES; ++i) {
+        dst[i] = (unsigned char) ((lens[2 * i] << 4) | (lens[2 * i + 1] & 0x0F));
+    }
+}
+
+static void lire_longueurs(const unsigned char *src, unsigned char lens[256]) {
+    for (int i = 0; i < HF_TABLE_BYTES; ++i) {
+        lens[2 * i] = (unsigned char) (src[i] >> 4);
+        lens[2 * i + 1] = (unsigned char) (src[i] & 0x0F);
+    }
+}
+
+/* Fenêtre de 57 bits au moins à la position pos, sans lire au-delà de p[len). */
+static inline uint64_t charger_fenetre(const unsigned char *p, size_t len, size_t pos) {
+    size_t o = pos >> 3;
+    if (o + 8 <= len) return bk_load_be64(p + o) << (pos & 7);
+    unsigned char tmp[8] = {0};
+    if (o < len) memcpy(tmp, p + o, len - o);
+    return bk_load_be64(tmp) << (pos & 7);
+}
+
+static void ecrire_quartets(unsigned char *dst, const unsigned char *lens, int n) {
+    for (int i = 0; i < n; i += 2) {
+        unsigned char bas = (i + 1 < n) ? (unsigned char) (lens[i + 1] & 0x0F) : 0;
+        dst[i / 2] = (unsigned char) ((lens[i] << 4) | bas);
+    }
+}
+
+static void lire_quartets(const unsigned char *src, unsigned char *lens, int n) {
+    for (int i = 0; i < n; ++i) {
+        lens[i] = (unsigned char) ((i & 1) ? (src[i / 2] & 0x0F) : (src[i / 2] >> 4));
+    }
+}
+
+/* Longueurs de code d'un alphabet de nsym symboles, limitées à HF_MAX_CODE_LEN. */
+static int longueurs_limitees(const unsigned long *freq, int nsym, unsigned char *lens) {
+    Noeud *root = construire_arbre_huffman_n(freq, nsym);
+    if (!root) return -1;
+    longueurs_codes_n(root, lens, nsym);
+    detruire_arbre(root);
+    return limiter_longueurs_n(lens, freq, nsym, HF_MAX_CODE_LEN);
+}
+
+/* ---------- Codes de longueur / distance (deflate) ---------- */
+
+#define LZ_NB_LONGUEURS  29
+#define LZ_NB_DISTANCES  30
+#define LZ_NB_LITLEN     (256 + LZ_NB_LONGUEURS)
+#define LZ_TABLE_BYTES   ((LZ_NB_LITLEN + 1) / 2 + LZ_NB_DISTANCES / 2)
+
+static const uint16_t lz_base_longueur[LZ_NB_LONGUEURS] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lz_extra_longueur[LZ_NB_LONGUEURS] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t lz_base_distance[LZ_NB_DISTANCES] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t lz_extra_distance[LZ_NB_DISTANCES] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* Code de longueur (0..28) d'une correspondance de l octets (3..258). */
+static inline int code_longueur(unsigned int l) {
+    if (l == LZ_MAX_MATCH) return 28;
+    unsigned int v = l - 3;
+    if (v < 8) return (int) v;
+    int b = 31 - __builtin_clz(v);
+    return 4 * (b - 1) + (int) ((v >> (b - 2)) & 3);
+}
+
+/* Code de distance (0..29) d'une distance d (1..32768). */
+static inline int code_distance(unsigned int d) {
+    unsigned int v = d - 1;
+    if (v < 4) return (int) v;
+    int b = 31 - __builtin_clz(v);
+    return 2 * b + (int) ((v >> (b - 1)) & 1);
+}
+
+/* ---------- Encodage ---------- */
+
+size_t codec_bound(size_t n) {
+    /* le codec stocké sert de repli : la charge utile ne dépasse jamais n */
+    return n;
+}
+
+/* Paire candidate : (nombre d'occurrences, paire = premier << 8 | second) */
+typedef struct {
+    uint32_t count;
+    uint16_t paire;
+} Candidate;
+
+static int comparer_candidates(const void *a, const void *b) {
+    const Candidate *x = (const Candidate*) a, *y = (const Candidate*) b;
+    if (x->count != y->count) return (x->count < y->count) ? 1 : -1;
+    return (int) x->paire - (int) y->paire;
+}
+
+static int comparer_paires(const void *a, const void *b) {
+    return (int) ((const Candidate*) a)->paire - (int) ((const Candidate*) b)->paire;
+}
+
+/* Choisit les paires de l'alphabet étendu : les HF_PAIRS_MAX plus fréquentes
+ * (au moins 8 occurrences : une paire doit payer ses 2,5 octets de table),
+ * rangées par ordre croissant dans cand[0..k). id : 65536 compteurs de travail.
+ */
+static int choisir_paires(const unsigned char *src, size_t n, uint32_t *id, Candidate *cand) {
+    /* histogramme des paires chevauchantes : estimation suffisante pour choisir */
+    memset(id, 0, 65536 * sizeof(uint32_t));
+    for (size_t i = 0; i + 1 < n; ++i) id[((unsigned) src[i] << 8) | src[i + 1]]++;
+    int nc = 0;
+    for (int p = 0; p < 65536; ++p) {
+        if (id[p] >= 8) {
+            cand[nc].count = id[p];
+            cand[nc].paire = (uint16_t) p;
+            nc++;
+        }
+    }
+    if (nc == 0) return 0;
+    qsort(cand, (size_t) nc, sizeof(Candidate), comparer_candidates);
+    int k = (nc < HF_PAIRS_MAX) ? nc : HF_PAIRS_MAX;
+    qsort(cand, (size_t) k, sizeof(Candidate), comparer_paires);
+    return k;
+}
+
+/* Encodage HF_CODEC_PAIRS avec les tampons de travail fournis.
+ * Retourne 0 si la charge utile (écrite dans dst) fait moins de 'limite'
+ * octets, 1 si l'alphabet étendu ne gagne rien, -1 en cas d'erreur.
+ */
+static int encoder_paires_tampons(const unsigned char *src, size_t n, unsigned char *dst,
+                                  size_t dst_cap, uint64_t limite, size_t *out_len,
+                                  uint32_t *id, uint16_t *tok, Candidate *cand) {
+    int k = choisir_paires(src, n, id, cand);
+    if (k == 0) return 1;
+
+    /* découpage glouton en symboles : id[paire] = 256 + rang, 0 = absente */
+    memset(id, 0, 65536 * sizeof(uint32_t));
+    for (int j = 0; j < k; ++j) id[cand[j].paire] = 256u + (uint32_t) j;
+    unsigned long freq[256 + HF_PAIRS_MAX];
+    memset(freq, 0, sizeof(freq));
+    size_t nt = 0;
+    size_t i = 0;
+    while (i < n) {
+        uint32_t s = (i + 1 < n) ? id[((unsigned) src[i] << 8) | src[i + 1]] : 0;
+        if (s) {
+            i += 2;
+        } else {
+            s = src[i];
+            i += 1;
+        }
+        tok[nt++] = (uint16_t) s;
+        freq[s]++;
+    }
+
+    const int nsym = 256 + k;
+    unsigned char lens[256 + HF_PAIRS_MAX];
+    if (longueurs_limitees(freq, nsym, lens) != 0) return -1;
+
+    /* table creuse : seules les paires réellement codées sont listées */
+    int u = 0;
+    uint64_t bits = 0;
+    for (int s = 0; s < nsym; ++s) {
+        bits += (uint64_t) freq[s] * lens[s];
+        if (s >= 256 && lens[s]) u++;
+    }
+    uint64_t taille = HF_TABLE_BYTES + 2 + 2 * (uint64_t) u + (uint64_t) (u + 1) / 2 + (bits + 7) / 8;
+    if (u == 0 || taille >= limite) return 1;
+
+    ecrire_longueurs(dst, lens);
+    unsigned char *q = dst + HF_TABLE_BYTES;
+    *q++ = (unsigned char) (u >> 8);
+    *q++ = (unsigned char) u;
+    unsigned char lens_paires[HF_PAIRS_MAX];
+    int m = 0;
+    for (int j = 0; j < k; ++j) {
+        if (!lens[256 + j]) continue;
+        *q++ = (unsigned char) (cand[j].paire >> 8);
+        *q++ = (unsigned char) cand[j].paire;
+        lens_paires[m++] = lens[256 + j];
+    }
+    ecrire_quartets(q, lens_paires, m);
+    q += (m + 1) / 2;
+
+    /* les symboles absents n'ont pas de code : la numérotation compacte du
+     * décodeur donne les mêmes codes canoniques */
+    uint32_t codes[256 + HF_PAIRS_MAX];
+    codes_canoniques_n(lens, codes, nsym);
+    BitWriter *bw = bw_create_mem(q, dst_cap - (size_t) (q - dst));
+    if (!bw) return -1;
+    int rc = 0;
+    for (size_t t = 0; t < nt && rc == 0; ++t) rc = bw_write_bits(bw, codes[tok[t]], lens[tok[t]]);
+    if (bw_write_flush(bw) != 0) rc = -1;
+    size_t produit = (size_t) (q - dst) + bw->len;
+    bw_destroy(bw);
+    if (rc != 0 || produit != taille) return -1;
+    *out_len = produit;
+    return 0;
+}
+
+static int encoder_paires(const unsigned char *src, size_t n, unsigned char *dst,
+                          size_t dst_cap, uint64_t limite, size_t *out_len) {
+    if (n < 2) return 1;
+    uint32_t *id = (uint32_t*) hf_malloc(65536 * sizeof(uint32_t));
+    uint16_t *tok = (uint16_t*) hf_malloc(n * sizeof(uint16_t));
+    Candidate *cand = (Candidate*) hf_malloc(65536 * sizeof(Candidate));
+    int rc = (id && tok && cand)
+             ? encoder_paires_tampons(src, n, dst, dst_cap, limite, out_len, id, tok, cand) : -1;
+    hf_free(id);
+    hf_free(tok);
+    hf_free(cand);
+    return rc;
+}
+
+/* Encodage HF_CODEC_LZ des séquences tok[0..nt). Mêmes retours que encoder_paires. */
+static int encoder_lz_sequences(const LzToken *tok, size_t nt, unsigned char *dst,
+                                size_t dst_cap, uint64_t limite, size_t *out_len) {
+    unsigned long freq_ll[LZ_NB_LITLEN], freq_d[LZ_NB_DISTANCES];
+    memset(freq_ll, 0, sizeof(freq_ll));
+    memset(freq_d, 0, sizeof(freq_d));
+    uint64_t extra = 0;
+    size_t correspondances = 0;
+    for (size_t t = 0; t < nt; ++t) {
+        if (tok[t].len == 0) {
+            freq_ll[tok[t].dist]++;
+            continue;
+        }
+        int cl = code_longueur(tok[t].len), cd = code_distance(tok[t].dist);
+        freq_ll[256 + cl]++;
+        freq_d[cd]++;
+        extra += lz_extra_longueur[cl] + lz_extra_distance[cd];
+        correspondances++;
+    }
+    if (correspondances == 0) return 1;
+
+    unsigned char lens_ll[LZ_NB_LITLEN], lens_d[LZ_NB_DISTANCES];
+    if (longueurs_limitees(freq_ll, LZ_NB_LITLEN, lens_ll) != 0) return -1;
+    if (longueurs_limitees(freq_d, LZ_NB_DISTANCES, lens_d) != 0) return -1;
+    uint64_t bits = extra;
+    for (int s = 0; s < LZ_NB_LITLEN; ++s) bits += (uint64_t) freq_ll[s] * lens_ll[s];
+    for (int s = 0; s < LZ_NB_DISTANCES; ++s) bits += (uint64_t) freq_d[s] * lens_d[s];
+    uint64_t taille = LZ_TABLE_BYTES + (bits + 7) / 8;
+    if (taille >= limite) return 1;
+
+    ecrire_quartets(dst, lens_ll, LZ_NB_LITLEN);
+    ecrire_quartets(dst + (LZ_NB_LITLEN + 1) / 2, lens_d, LZ_NB_DISTANCES);
+    uint32_t codes_ll[LZ_NB_LITLEN], codes_d[LZ_NB_DISTANCES];
+    codes_canoniques_n(lens_ll, codes_ll, LZ_NB_LITLEN);
+    codes_canoniques_n(lens_d, codes_d, LZ_NB_DISTANCES);
+
+    BitWriter *bw = bw_create_mem(dst + LZ_TABLE_BYTES, dst_cap - LZ_TABLE_BYTES);
+    if (!bw) return -1;
+    int rc = 0;
+    for (size_t t = 0; t < nt && rc == 0; ++t) {
+        unsigned int l = tok[t].len, d = tok[t].dist;
+        if (l == 0) {
+            rc = bw_write_bits(bw, codes_ll[d], lens_ll[d]);
+            continue;
+        }
+        /* code + bits supplémentaires en une seule écriture (<= 25 bits chacun) */
+        int cl = code_longueur(l), cd = code_distance(d);
+        int el = lz_extra_longueur[cl], ed = lz_extra_distance[cd];
+        rc = bw_write_bits(bw, ((uint64_t) codes_ll[256 + cl] << el) | (l - lz_base_longueur[cl]),
+                           lens_ll[256 + cl] + el);
+        if (rc == 0) {
+            rc = bw_write_bits(bw, ((uint64_t) codes_d[cd] << ed) | (d - lz_base_distance[cd]),
+                               lens_d[cd] + ed);
+        }
+    }
+    if (bw_write_flush(bw) != 0) rc = -1;
+    size_t produit = LZ_TABLE_BYTES + bw->len;
+    bw_destroy(bw);
+    if (rc != 0 || produit != taille) return -1;
+    *out_len = produit;
+    return 0;
+}
+
+static int encoder_lz(const unsigned char *src, size_t n, int niveau, unsigned char *dst,
+                      size_t dst_cap, uint64_t limite, size_t *out_len) {
+    if (n < LZ_MIN_MATCH + 1) return 1;
+    LzToken *tok = (LzToken*) hf_malloc(n * sizeof(LzToken));
+    if (!tok) return -1;
+    TRACE_DEBUT(t_parse);
+    size_t nt = lz_parse(src, n, niveau, tok);
+    TRACE_FIN(t_parse, "lz_parse", n);
+    int rc = (nt == (size_t) -1) ? -1 : encoder_lz_sequences(tok, nt, dst, dst_cap, limite, out_len);
+    hf_free(tok);
+    return rc;
+}
+
+/* ---------- BWT + MTF + suites de zéros ---------- */
+
+/* Alphabet après MTF : RUNA, RUNB (suite de zéros en base 2 bijective),
+ * puis rang MTF r (1..255) -> symbole r + 1.
+ */
+#define BWT_RUNA    0
+#define BWT_RUNB    1
+#define BWT_NB_SYM  257
+#define BWT_TABLE_BYTES (4 + (BWT_NB_SYM + 1) / 2)
+
+/* Émet une suite de r zéros MTF (r >= 1) en RUNA/RUNB. */
+static size_t emettre_suite(uint16_t *sym, size_t k, size_t r, unsigned long *freq) {
+    r--;
+    for (;;) {
+        uint16_t v = (r & 1) ? BWT_RUNB : BWT_RUNA;
+        sym[k++] = v;
+        freq[v]++;
+        if (r < 2) break;
+        r = (r - 2) / 2;
+    }
+    return k;
+}
+
+/* Move-to-front + suites de zéros de L[0..n) ; retourne le nombre de symboles. */
+static size_t mtf_suites(const unsigned char *L, size_t n, uint16_t *sym, unsigned long *freq) {
+    unsigned char liste[256];
+    for (int i = 0; i < 256; ++i) liste[i] = (unsigned char) i;
+    size_t k = 0, suite = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = L[i];
+        if (liste[0] == c) {
+            suite++;
+            continue;
+        }
+        if (suite) {
+            k = emettre_suite(sym, k, suite, freq);
+            suite = 0;
+        }
+        int r = 1;
+        while (liste[r] != c) r++;
+        memmove(liste + 1, liste, (size_t) r);
+        liste[0] = c;
+        sym[k++] = (uint16_t) (r + 1);
+        freq[r + 1]++;
+    }
+    if (suite) k = emettre_suite(sym, k, suite, freq);
+    return k;
+}
+
+/* Encodage HF_CODEC_BWT avec les tampons fournis (L : n octets, sym : n + 1 symboles). */
+static int encoder_bwt_tampons(const unsigned char *src, size_t n, unsigned char *dst,
+                               size_t dst_cap, uint64_t limite, size_t *out_len,
+                               unsigned char *L, uint16_t *sym) {
+    uint32_t primary;
+    TRACE_DEBUT(t_bwt);
+    if (bwt_forward(src, n, L, &primary) != 0) return -1;
+    TRACE_FIN(t_bwt, "bwt_forward", n);
+    unsigned long freq[BWT_NB_SYM];
+    memset(freq, 0, sizeof(freq));
+    size_t ns = mtf_suites(L, n, sym, freq);
+
+    unsigned char lens[BWT_NB_SYM];
+    if (longueurs_limitees(freq, BWT_NB_SYM, lens) != 0) return -1;
+    uint64_t bits = 0;
+    for (int v = 0; v < BWT_NB_SYM; ++v) bits += (uint64_t) freq[v] * lens[v];
+    uint64_t taille = BWT_TABLE_BYTES + (bits + 7) / 8;
+    if (taille >= limite) return 1;
+
+    dst[0] = (unsigned char) (primary >> 24);
+    dst[1] = (unsigned char) (primary >> 16);
+    dst[2] = (unsigned char) (primary >> 8);
+    dst[3] = (unsigned char) primary;
+    ecrire_quartets(dst + 4, lens, BWT_NB_SYM);
+    uint32_t codes[BWT_NB_SYM];
+    codes_canoniques_n(lens, codes, BWT_NB_SYM);
+
+    BitWriter *bw = bw_create_mem(dst + BWT_TABLE_BYTES, dst_cap - BWT_TABLE_BYTES);
+    if (!bw) return -1;
+    int rc = 0;
+    for (size_t k = 0; k < ns && rc == 0; ++k) rc = bw_write_bits(bw, codes[sym[k]], lens[sym[k]]);
+    if (bw_write_flush(bw) != 0) rc = -1;
+    size_t produit = BWT_TABLE_BYTES + bw->len;
+    bw_destroy(bw);
+    if (rc != 0 || produit != taille) return -1;
+    *out_len = produit;
+    return 0;
+}
+
+static int encoder_bwt(const unsigned char *src, size_t n, unsigned char *dst,
+                       size_t dst_cap, uint64_t limite, size_t *out_len) {
+    if (n < 2 || n > BWT_MAX_SIZE) return 1;
+    unsigned char *L = (unsigned char*) hf_malloc(n);
+    uint16_t *sym = (uint16_t*) hf_malloc((n + 1) * sizeof(uint16_t));
+    int rc = (L && sym) ? encoder_bwt_tampons(src, n, dst, dst_cap, limite, out_len, L, sym) : -1;
+    hf_free(L);
+    hf_free(sym);
+    return rc;
+}
+
+void codec_table_reset(CodecTable *t) {
+    if (t) t->valide = 0;
+}
+
+/* Écrit le flux de bits de src[0..n) codé par (codes, lens) ; la taille
+ * attendue sert de contrôle. */
+static int encoder_flux(const unsigned char *src, size_t n, unsigned char *dst, size_t dst_cap,
+                        const uint32_t *codes, const unsigned char *lens, size_t attendu) {
+    BitWriter *bw = bw_create_mem(dst, dst_cap);
+    if (!bw) return -1;
+    int rc = bit_kernels()->encode(bw, src, n, codes, lens);
+    if (bw_write_flush(bw) != 0) rc = -1;
+    size_t produit = bw->len;
+    bw_destroy(bw);
+    return (rc != 0 || produit != attendu) ? -1 : 0;
+}
+
+/* Découpage d'un bloc en ns flux (1 ou 4) : quarts consécutifs de
+ * (n + 3) / 4 symboles, le dernier éventuellement plus court. */
+static void quarts(size_t n, int ns, size_t debut[4], size_t cnt[4]) {
+    size_t q = (ns == 1) ? n : (n + 3) / 4;
+    for (int s = 0; s < ns; ++s) {
+        size_t d = (size_t) s * q;
+        debut[s] = (d < n) ? d : n;
+        cnt[s] = (d < n) ? ((n - d < q) ? n - d : q) : 0;
+    }
+}
+
+/* Taille des flux (sans la table) pour les histogrammes par flux qf et les
+ * longueurs lens, tailles des flux dans t ; UINT64_MAX si un symbole présent
+ * n'a pas de code. */
+static uint64_t taille_flux(unsigned long qf[4][256], int ns, const unsigned char *lens, uint64_t t[4]) {
+    uint64_t total = (ns == 4) ? HF_STREAMS_HEADER : 0;
+    for (int s = 0; s < ns; ++s) {
+        uint64_t b = 0;
+        for (int c = 0; c < 256; ++c) {
+            if (qf[s][c] && !lens[c]) return UINT64_MAX;
+            b += (uint64_t) qf[s][c] * lens[c];
+        }
+        t[s] = (b + 7) / 8;
+        total += t[s];
+    }
+    return total;
+}
+
+/* Écrit les ns flux de src (et la table des tailles si ns == 4). */
+static int encoder_flux_multi(const unsigned char *src, size_t n, unsigned char *dst, size_t dst_cap,
+                              int ns, const uint32_t *codes, const unsigned char *lens,
+                              const uint64_t t[4]) {
+    if (ns == 1) return encoder_flux(src, n, dst, dst_cap, codes, lens, (size_t) t[0]);
+    size_t debut[4], cnt[4];
+    quarts(n, ns, debut, cnt);
+    for (int s = 0; s < 3; ++s) {
+        dst[4 * s] = (unsigned char) (t[s] >> 24);
+        dst[4 * s + 1] = (unsigned char) (t[s] >> 16);
+        dst[4 * s + 2] = (unsigned char) (t[s] >> 8);
+        dst[4 * s + 3] = (unsigned char) t[s];
+    }
+    size_t o = HF_STREAMS_HEADER;
+    for (int s = 0; s < ns; ++s) {
+        if (encoder_flux(src + debut[s], cnt[s], dst + o, dst_cap - o, codes, lens, (size_t) t[s]) != 0) return -1;
+        o += (size_t) t[s];
+    }
+    return 0;
+}
+
+/* Entropie d'ordre 0, en bits par octet, d'un bloc de n octets d'histogramme freq. */
+static double entropie(const unsigned long freq[256], size_t n) {
+    double h = 0.0;
+    for (int c = 0; c < 256; ++c) {
+        if (freq[c] == 0) continue;
+        double p = (double) freq[c] / (double) n;
+        h -= p * log2(p);
+    }
+    return h;
+}
+
+int codec_encode_block(const unsigned char *src, size_t n,
+                       unsigned char *dst, size_t dst_cap, int prefere, int niveau,
+                       CodecTable *tab, int *out_codec, int *out_flags, size_t *out_len,
+                       double *out_entropy) {
+    if ((!src && n > 0) || !dst || !out_codec || !out_flags || !out_len) return -1;
+    if (dst_cap < codec_bound(n) + 16) return -1;
+    *out_flags = 0;
+
+    /* histogramme par flux : la taille exacte de chaque flux en découle */
+    const int ns = (n >= HF_STREAMS_MIN) ? 4 : 1;
+    size_t debut[4], cnt[4];
+    quarts(n, ns, debut, cnt);
+    unsigned long qfreq[4][256], freq[256];
+    TRACE_DEBUT(t_histo);
+    for (int k = 0; k < ns; ++k) histogramme(src + debut[k], cnt[k], qfreq[k]);
+    for (int c = 0; c < 256; ++c) {
+        freq[c] = qfreq[0][c];
+        for (int k = 1; k < ns; ++k) freq[c] += qfreq[k][c];
+    }
+    TRACE_FIN(t_histo, "histogramme", n);
+    const double h = (n > 0) ? entropie(freq, n) : 0.0;
+    if (out_entropy) *out_entropy = h;
+
+    /* table précédente d'abord : utilisable si elle code tous les symboles présents */
+    uint64_t t_flux[4], t_reprise[4];
+    uint64_t taille_reprise = UINT64_MAX;
+    if (tab && tab->valide && n > 0) taille_reprise = taille_flux(qfreq, ns, tab->lens, t_reprise);
+
+    /* Une nouvelle table coûte au moins ses HF_TABLE_BYTES plus l'entropie du
+     * bloc : une reprise à moins de HF_REUSE_TOLERANCE de cette borne est
+     * acceptée sans construire l'arbre. Sinon l'arbre décide au bit près. */
+    const double borne = (double) (HF_TABLE_BYTES + ((ns == 4) ? HF_STREAMS_HEADER : 0)) + h * (double) n / 8.0;
+    uint64_t taille = UINT64_MAX;
+    unsigned char lens[256];
+    memset(lens, 0, sizeof(lens));
+    if (n > 0 && (double) taille_reprise > borne * (1.0 + HF_REUSE_TOLERANCE)) {
+        TRACE_DEBUT(t_arbre);
+        Noeud *root = construire_arbre_huffman(freq);
+        if (!root) return -1;
+        longueurs_codes(root, lens);
+        detruire_arbre(root);
+        if (limiter_longueurs(lens, freq, HF_MAX_CODE_LEN) != 0) return -1;
+        TRACE_FIN(t_arbre, "construire_arbre_huffman", n);
+        taille = HF_TABLE_BYTES + taille_flux(qfreq, ns, lens, t_flux);
+    }
+    uint64_t limite = (taille_reprise < taille) ? taille_reprise : taille;
+    if (limite > n) limite = n;
+
+    if (prefere == HF_CODEC_PAIRS && n > 0) {
+        TRACE_DEBUT(t_paires);
+        int r = encoder_paires(src, n, dst, dst_cap, limite, out_len);
+        TRACE_FIN(t_paires, "encodage paires", n);
+        if (r <= 0) {
+            *out_codec = HF_CODEC_PAIRS;
+            codec_table_reset(tab);
+            return r;
+        }
+    }
+    if (prefere == HF_CODEC_LZ && n > 0) {
+        TRACE_DEBUT(t_lz);
+        int r = encoder_lz(src, n, niveau, dst, dst_cap, limite, out_len);
+        TRACE_FIN(t_lz, "encodage lz", n);
+        if (r <= 0) {
+            *out_codec = HF_CODEC_LZ;
+            codec_table_reset(tab);
+            return r;
+        }
+    }
+    if (prefere == HF_CODEC_BWT && n > 0) {
+        TRACE_DEBUT(t_bwt);
+        int r = encoder_bwt(src, n, dst, dst_cap, limite, out_len);
+        TRACE_FIN(t_bwt, "encodage bwt", n);
+        if (r <= 0) {
+            *out_codec = HF_CODEC_BWT;
+            codec_table_reset(tab);
+            return r;
+        }
+    }
+
+    if (n == 0 || limite >= n) {
+        /* Huffman ne gagne rien (données aléatoires, bloc minuscule) : stocker */
+        if (n > 0) memcpy(dst, src, n);
+        *out_codec = HF_CODEC_STORED;
+        *out_len = n;
+        codec_table_reset(tab);
+        return 0;
+    }
+
+    *out_codec = HF_CODEC_HUFF;
+    if (taille_reprise <= taille) {
+        TRACE_DEBUT(t_enc);
+        if (encoder_flux_multi(src, n, dst, dst_cap, ns, tab->codes, tab->lens, t_reprise) != 0) return -1;
+        TRACE_FIN(t_enc, "encodage huff", n);
+        *out_flags = HF_BLOCK_REUSE_TABLE | ((ns == 4) ? HF_BLOCK_4STREAMS : 0);
+        *out_len = (size_t) taille_reprise;
+        return 0;
+    }
+
+    uint32_t codes[256];
+    TRACE_DEBUT(t_codes);
+    codes_canoniques(lens, codes);
+    ecrire_longueurs(dst, lens);
+    TRACE_FIN(t_codes, "codes canoniques", 256);
+    TRACE_DEBUT(t_enc);
+    if (encoder_flux_multi(src, n, dst + HF_TABLE_BYTES, dst_cap - HF_TABLE_BYTES, ns, codes, lens,
+                           t_flux) != 0) return -1;
+    TRACE_FIN(t_enc, "encodage huff", n);
+    if (ns == 4) *out_flags = HF_BLOCK_4STREAMS;
+    if (tab) {
+        memcpy(tab->lens, lens, sizeof(lens));
+        memcpy(tab->codes, codes, sizeof(codes));
+        tab->valide = 1;
+    }
+    *out_len = (size_t) taille;
+    return 0;
+}
+
+/* ---------- Décodage ---------- */
+
+/* Table de décodage : entrée = (valeur << 4) | longueur, indexée par les
+ * 'bits' prochains bits du flux (valeur = symbole, ou octets produits en mode
+ * paires). Une entrée de longueur 0 signale un code inexistant (flux corrompu).
+ * Retourne 0 si OK, -1 si les longueurs ne forment pas un code préfixe.
+ */
+static int construire_table(const unsigned char *lens, const uint32_t *valeurs, int nsym,
+                            uint32_t *table, int *out_bits) {
+    if (nsym > 256 + HF_PAIRS_MAX) return -1;
+    TRACE_DEBUT(t_table);
+    int bits = 0;
+    for (int s = 0; s < nsym; ++s) {
+        if (lens[s] > HF_MAX_CODE_LEN) return -1;
+        if (lens[s] > bits) bits = lens[s];
+    }
+    if (bits == 0) return -1;
+
+    uint32_t kraft = 0;
+    for (int s = 0; s < nsym; ++s) {
+        if (lens[s]) kraft += 1U << (bits - lens[s]);
+    }
+    if (kraft > (1U << bits)) return -1;
+    if (bits < HF_TABLE_MIN_BITS) bits = HF_TABLE_MIN_BITS;   /* noyaux spécialisés : 8 bits et plus */
+
+    uint32_t codes[256 + HF_PAIRS_MAX];
+    codes_canoniques_n(lens, codes, nsym);
+    memset(table, 0, sizeof(uint32_t) << bits);
+    for (int s = 0; s < nsym; ++s) {
+        if (!lens[s]) continue;
+        uint32_t debut = codes[s] << (bits - lens[s]);
+        uint32_t fin = (codes[s] + 1) << (bits - lens[s]);
+        uint32_t e = ((valeurs ? valeurs[s] : (uint32_t) s) << 4) | lens[s];
+        for (uint32_t k = debut; k < fin; ++k) table[k] = e;
+    }
+    *out_bits = bits;
+    TRACE_FIN(t_table, "table de décodage", nsym);
+    return 0;
+}
+
+int codec_table_load(CodecTable *t, const unsigned char *table) {
+    if (!t || !table) return -1;
+    lire_longueurs(table, t->lens);
+    t->valide = (construire_table(t->lens, NULL, 256, t->dec, &t->bits) == 0);
+    return t->valide ? 0 : -1;
+}
+
+/* Fin d'un flux à partir de la position pos : chargements bornés par
+ * charger_fenetre, largeur de table quelconque. Sert aussi de chemin générique
+ * (HUFFMAN_DECODE=generic) pour mesurer les noyaux spécialisés.
+ */
+static int decoder_queue(const uint32_t *table, int bits, const unsigned char *p, size_t plen,
+                         size_t pos, unsigned char *dst, size_t n) {
+    const int sh = 64 - bits;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t w = charger_fenetre(p, plen, pos);
+        uint32_t e = table[w >> sh];
+        if ((e & 15) == 0) return -1;
+        dst[i] = (unsigned char) (e >> 4);
+        pos += e & 15;
+    }
+    return (pos <= plen * 8) ? 0 : -1;
+}
+
+typedef int (*NoyauHuff)(const uint32_t *table, const unsigned char *const *flux, const size_t *tailles,
+                         unsigned char *dst, size_t n);
+
+/* Noyaux spécialisés (decode_tmpl.h) : largeurs 8..12, 1 ou 4 flux. */
+#define DK_STREAMS 1
+#define DK_BITS 8
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 9
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 10
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 11
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 12
+#include "decode_tmpl.h"
+#undef DK_BITS
+#undef DK_STREAMS
+#define DK_STREAMS 4
+#define DK_BITS 8
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 9
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 10
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 11
+#include "decode_tmpl.h"
+#undef DK_BITS
+#define DK_BITS 12
+#include "decode_tmpl.h"
+#undef DK_BITS
+#undef DK_STREAMS
+
+static const NoyauHuff noyaux_huff[HF_MAX_CODE_LEN - HF_TABLE_MIN_BITS + 1][2] = {
+    { decoder_huff_8_1f,  decoder_huff_8_4f },
+    { decoder_huff_9_1f,  decoder_huff_9_4f },
+    { decoder_huff_10_1f, decoder_huff_10_4f },
+    { decoder_huff_11_1f, decoder_huff_11_4f },
+    { decoder_huff_12_1f, decoder_huff_12_4f },
+};
+
+#define DECODE_SPECIALISE 0
+#define DECODE_GENERIQUE  1
+#define DECODE_COMPACT    2
+
+/* HUFFMAN_DECODE=generic : boucle générique (largeur lue à l'exécution) au
+ * lieu des noyaux spécialisés, pour les comparer ; HUFFMAN_DECODE=compact :
+ * décodeur canonique compact (canon.h), sans table directe. Lu une seule fois. */
+static int mode_decodage(void) {
+    static atomic_int choix = -1;
+    int c = atomic_load(&choix);
+    if (c < 0) {
+        const char *e = getenv("HUFFMAN_DECODE");
+        c = DECODE_SPECIALISE;
+        if (e && strcmp(e, "generic") == 0) c = DECODE_GENERIQUE;
+        else if (e && strcmp(e, "compact") == 0) c = DECODE_COMPACT;
+        atomic_store(&choix, c);
+    }
+    return c;
+}
+
+/* Décodage par canon.h : seules les longueurs de la table servent. */
+static int decoder_compact(const unsigned char *lens, const unsigned char *const *flux,
+                           const size_t *tailles, int ns, unsigned char *dst, size_t n) {
+    HfCanon c;
+    if (canon_init(&c, lens) != 0) return -1;
+    size_t debut[4], cnt[4];
+    quarts(n, ns, debut, cnt);
+    for (int s = 0; s < ns; ++s) {
+        size_t lus;
+        canon_start(&c);
+        if (canon_decode(&c, flux[s], tailles[s], &lus, dst + debut[s], cnt[s]) != cnt[s]) return -1;
+    }
+    return 0;
+}
+
+/* tab == NULL : table locale ; sinon la table lue (ou reprise) y reste pour
+ * le bloc suivant. */
+static int decoder_huff(const unsigned char *payload, size_t len, unsigned char *dst, size_t n,
+                        int flags, CodecTable *tab) {
+    const int reprise = flags & HF_BLOCK_REUSE_TABLE;
+    const int mode = mode_decodage();
+    uint32_t locale[1 << HF_MAX_CODE_LEN];
+    const uint32_t *table = NULL;
+    int bits = 0;
+    unsigned char lens[256];
+    const unsigned char *p = payload;
+    size_t plen = len;
+
+    if (reprise) {
+        if (!tab || !tab->valide) return -1;
+        table = tab->dec;
+        bits = tab->bits;
+        if (mode == DECODE_COMPACT) memcpy(lens, tab->lens, sizeof(lens));
+    } else {
+        if (len < HF_TABLE_BYTES) return -1;
+        if (mode == DECODE_COMPACT) {
+            /* pas de table directe : les longueurs suffisent (et la reprise
+             * par le bloc suivant ne demande qu'elles) */
+            lire_longueurs(payload, lens);
+            if (tab) {
+                memcpy(tab->lens, lens, sizeof(lens));
+                tab->valide = 1;
+            }
+        } else if (tab) {
+            if (codec_table_load(tab, payload) != 0) return -1;
+            table = tab->dec;
+            bits = tab->bits;
+        } else {
+            lire_longueurs(payload, lens);
+            if (construire_table(lens, NULL, 256, locale, &bits) != 0) return -1;
+            table = locale;
+        }
+        p += HF_TABLE_BYTES;
+        plen -= HF_TABLE_BYTES;
+    }
+
+    const unsigned char *flux[4] = { p, NULL, NULL, NULL };
+    size_t tailles[4] = { plen, 0, 0, 0 };
+    const int ns = (flags & HF_BLOCK_4STREAMS) ? 4 : 1;
+    if (ns == 4) {
+        if (plen < HF_STREAMS_HEADER) return -1;
+        size_t reste = plen - HF_STREAMS_HEADER;
+        const unsigned char *q = p + HF_STREAMS_HEADER;
+        for (int s = 0; s < 3; ++s) {
+            tailles[s] = ((size_t) p[4 * s] << 24) | ((size_t) p[4 * s + 1] << 16) |
+                         ((size_t) p[4 * s + 2] << 8) | p[4 * s + 3];
+            if (tailles[s] > reste) return -1;
+            flux[s] = q;
+            q += tailles[s];
+            reste -= tailles[s];
+        }
+        flux[3] = q;
+        tailles[3] = reste;
+    }
+
+    if (mode == DECODE_COMPACT) return decoder_compact(lens, flux, tailles, ns, dst, n);
+    if (mode == DECODE_GENERIQUE) {
+        size_t debut[4], cnt[4];
+        quarts(n, ns, debut, cnt);
+        for (int s = 0; s < ns; ++s) {
+            if (decoder_queue(table, bits, flux[s], tailles[s], 0, dst + debut[s], cnt[s]) != 0) return -1;
+        }
+        return 0;
+    }
+    return noyaux_huff[bits - HF_TABLE_MIN_BITS][ns == 4](table, flux, tailles, dst, n);
+}
+
+/* Mode paires : valeur = octet0 | octet1 << 8 | nombre d'octets produits << 16 */
+static int decoder_paires(const unsigned char *payload, size_t len, unsigned char *dst, size_t n) {
+    if (len < HF_TABLE_BYTES + 2) return -1;
+    unsigned char lens[256 + HF_PAIRS_MAX];
+    uint32_t valeurs[256 + HF_PAIRS_MAX];
+    lire_longueurs(payload, lens);
+    for (int s = 0; s < 256; ++s) valeurs[s] = (uint32_t) s | (1u << 16);
+
+    const unsigned char *q = payload + HF_TABLE_BYTES;
+    int k = (q[0] << 8) | q[1];
+    q += 2;
+    size_t table_len = HF_TABLE_BYTES + 2 + 2 * (size_t) k + (size_t) (k + 1) / 2;
+    if (k < 1 || k > HF_PAIRS_MAX || len < table_len) return -1;
+    for (int j = 0; j < k; ++j) {
+        valeurs[256 + j] = (uint32_t) q[2 * j] | ((uint32_t) q[2 * j + 1] << 8) | (2u << 16);
+        unsigned char l = q[2 * k + j / 2];
+        lens[256 + j] = (unsigned char) ((j & 1) ? (l & 0x0F) : (l >> 4));
+        if (!lens[256 + j]) return -1;
+    }
+
+    uint32_t table[1 << HF_MAX_CODE_LEN];
+    int bits;
+    if (construire_table(lens, valeurs, 256 + k, table, &bits) != 0) return -1;
+
+    const unsigned char *p = payload + table_len;
+    size_t plen = len - table_len;
+    size_t pos = 0;
+    const int sh = 64 - bits;
+
+    /* deux octets écrits à chaque symbole tant qu'il reste de la place */
+    size_t i = 0;
+    while (i + 2 <= n) {
+        uint64_t w = charger_fenetre(p, plen, pos);
+        uint32_t e = table[w >> sh];
+        if ((e & 15) == 0) return -1;
+        dst[i] = (unsigned char) (e >> 4);
+        dst[i + 1] = (unsigned char) (e >> 12);
+        i += (e >> 20) & 3;
+        pos += e & 15;
+    }
+    if (i < n) {
+        uint32_t e = table[charger_fenetre(p, plen, pos) >> sh];
+        if ((e & 15) == 0 || ((e >> 20) & 3) != 1) return -1;
+        dst[i] = (unsigned char) (e >> 4);
+        pos += e & 15;
+    }
+    return (pos <= plen * 8) ? 0 : -1;
+}
+
+/* Mode LZ : valeur littéral/longueur = octet, ou LZ_VAL_MATCH | base | bits sup. << 9 ;
+ * valeur distance = base | bits sup. << 15.
+ */
+#define LZ_VAL_MATCH (1u << 13)
+
+static int decoder_lz(const unsigned char *payload, size_t len, unsigned char *dst, size_t n) {
+    if (len < LZ_TABLE_BYTES) return -1;
+    unsigned char lens_ll[LZ_NB_LITLEN], lens_d[LZ_NB_DISTANCES];
+    uint32_t val_ll[LZ_NB_LITLEN], val_d[LZ_NB_DISTANCES];
+    lire_quartets(payload, lens_ll, LZ_NB_LITLEN);
+    lire_quartets(payload + (LZ_NB_LITLEN + 1) / 2, lens_d, LZ_NB_DISTANCES);
+    for (int s = 0; s < 256; ++s) val_ll[s] = (uint32_t) s;
+    for (int c = 0; c < LZ_NB_LONGUEURS; ++c) {
+        val_ll[256 + c] = LZ_VAL_MATCH | lz_base_longueur[c] | ((uint32_t) lz_extra_longueur[c] << 9);
+    }
+    for (int c = 0; c < LZ_NB_DISTANCES; ++c) {
+        val_d[c] = lz_base_distance[c] | ((uint32_t) lz_extra_distance[c] << 15);
+    }
+
+    uint32_t table_ll[1 << HF_MAX_CODE_LEN], table_d[1 << HF_MAX_CODE_LEN];
+    int bits_ll, bits_d;
+    if (construire_table(lens_ll, val_ll, LZ_NB_LITLEN, table_ll, &bits_ll) != 0) return -1;
+    if (construire_table(lens_d, val_d, LZ_NB_DISTANCES, table_d, &bits_d) != 0) return -1;
+
+    const unsigned char *p = payload + LZ_TABLE_BYTES;
+    size_t plen = len - LZ_TABLE_BYTES;
+    size_t pos = 0;
+    const int sh_ll = 64 - bits_ll, sh_d = 64 - bits_d;
+
+    /* une séquence consomme au plus 12 + 5 + 12 + 13 = 42 bits : une fenêtre suffit */
+    size_t i = 0;
+    while (i < n) {
+        uint64_t w = charger_fenetre(p, plen, pos);
+        uint32_t e = table_ll[w >> sh_ll];
+        unsigned int l = e & 15;
+        if (l == 0) return -1;
+        uint32_t v = e >> 4;
+        if (!(v & LZ_VAL_MATCH)) {
+            dst[i++] = (unsigned char) v;
+            pos += l;
+            continue;
+        }
+        w <<= l;
+        unsigned int el = (v >> 9) & 7;
+        size_t m = (v & 511) + (el ? (size_t) (w >> (64 - el)) : 0);
+        w <<= el;
+        uint32_t ed_e = table_d[w >> sh_d];
+        unsigned int ld = ed_e & 15;
+        if (ld == 0) return -1;
+        uint32_t vd = ed_e >> 4;
+        w <<= ld;
+        unsigned int ed = (vd >> 15) & 15;
+        size_t dist = (vd & 0x7FFF) + (ed ? (size_t) (w >> (64 - ed)) : 0);
+        pos += l + el + ld + ed;
+        if (dist > i || m > n - i) return -1;
+        lz_copier(dst + i, dist, m, dst + n);
+        i += m;
+    }
+    return (pos <= plen * 8) ? 0 : -1;
+}
+
+/* Mode BWT : symboles -> colonne L (dans dst) -> inverse en place. */
+static int decoder_bwt(const unsigned char *payload, size_t len, unsigned char *dst, size_t n) {
+    if (len < BWT_TABLE_BYTES || n == 0 || n > BWT_MAX_SIZE) return -1;
+    uint32_t primary = ((uint32_t) payload[0] << 24) | ((uint32_t) payload[1] << 16) |
+                       ((uint32_t) payload[2] << 8) | payload[3];
+    unsigned char lens[BWT_NB_SYM];
+    lire_quartets(payload + 4, lens, BWT_NB_SYM);
+    uint32_t table[1 << HF_MAX_CODE_LEN];
+    int bits;
+    if (construire_table(lens, NULL, BWT_NB_SYM, table, &bits) != 0) return -1;
+
+    const unsigned char *p = payload + BWT_TABLE_BYTES;
+    size_t plen = len - BWT_TABLE_BYTES;
+    size_t pos = 0;
+    const int sh = 64 - bits;
+
+    unsigned char liste[256];
+    for (int i = 0; i < 256; ++i) liste[i] = (unsigned char) i;
+    size_t i = 0;
+    size_t suite = 0, poids = 1;
+    while (i < n || suite) {
+        uint32_t v = BWT_NB_SYM; /* fin du bloc : vider la suite en attente */
+        if (i + suite < n) {
+            uint32_t e = table[charger_fenetre(p, plen, pos) >> sh];
+            if ((e & 15) == 0) return -1;
+            pos += e & 15;
+            v = e >> 4;
+            if (v <= BWT_RUNB) {
+                suite += poids << v;
+                poids <<= 1;
+                if (suite > n - i) return -1;
+                continue;
+            }
+        }
+        if (suite) {
+            memset(dst + i, liste[0], suite);
+            i += suite;
+            suite = 0;
+            poids = 1;
+        }
+        if (v == BWT_NB_SYM) break;
+        int r = (int) v - 1;
+        unsigned char c = liste[r];
+        memmove(liste + 1, liste, (size_t) r);
+        liste[0] = c;
+        dst[i++] = c;
+    }
+    if (i != n || pos > plen * 8) return -1;
+    TRACE_DEBUT(t_inv);
+    int rc = bwt_inverse(dst, n, primary, dst);
+    TRACE_FIN(t_inv, "bwt_inverse", n);
+    return rc;
+}
+
+int codec_decode_block(int codec, int flags, const unsigned char *payload, size_t len,
+                       unsigned char *dst, size_t raw_size, CodecTable *tab) {
+    if ((!payload && len > 0) || (!dst && raw_size > 0)) return -1;
+    if (flags & ~(HF_BLOCK_REUSE_TABLE | HF_BLOCK_4STREAMS)) return -1;
+    if (codec != HF_CODEC_HUFF) {
+        if (flags) return -1;
+        codec_table_reset(tab);
+    }
+    TRACE_DEBUT(t_dec);
+    int rc;
+    switch (codec) {
+        case HF_CODEC_STORED:
+            rc = (len == raw_size) ? 0 : -1;
+            if (rc == 0 && raw_size > 0) memcpy(dst, payload, raw_size);
+            break;
+        case HF_CODEC_HUFF:
+            rc = decoder_huff(payload, len, dst, raw_size, flags, tab);
+            break;
+        case HF_CODEC_PAIRS:
+            rc = decoder_paires(payload, len, dst, raw_size);
+            break;
+        case HF_CODEC_LZ:
+            rc = decoder_lz(payload, len, dst, raw_size);
+            break;
+        case HF_CODEC_BWT:
+            rc = decoder_bwt(payload, len, dst, raw_size);
+            break;
+        default:
+            return -1;
+    }
+    TRACE_FIN(t_dec, "decodage", raw_size);
+    return rc;
+}
@@ -0,0 +1,147 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+/*
+ * codec.h
+ *
+ * Codage d'un bloc en mémoire (format HUF2, voir archive.h).
+ *
+ * Un bloc est encodé indépendamment des autres :
+ * - HF_CODEC_STORED : octets bruts (données incompressibles) ;
+ * - HF_CODEC_HUFF   : Huffman ordre 0 canonique, longueurs limitées à
+ *                     HF_MAX_CODE_LEN bits ;
+ * - HF_CODEC_PAIRS  : Huffman sur un alphabet étendu (256 octets + jusqu'à
+ *                     HF_PAIRS_MAX paires d'octets fréquentes) : un symbole
+ *                     décodé produit un ou deux octets (textes) ;
+ * - HF_CODEC_LZ     : LZ77 (lz77.h) puis Huffman sur les alphabets
+ *                     littéral/longueur et distance de deflate ;
+ * - HF_CODEC_BWT    : Burrows-Wheeler (bwt.h), move-to-front, suites de
+ *                     zéros RUNA/RUNB, puis Huffman (taux élevé, archivage).
+ *
+ * Charge utile HF_CODEC_HUFF :
+ *   128 octets : longueurs de code des 256 symboles, 4 bits chacune
+ *                (symbole pair dans le quartet de poids fort, 0 = absent)
+ *   flux de bits MSB-first, complété par des zéros jusqu'à l'octet.
+ * Avec le drapeau de bloc HF_BLOCK_REUSE_TABLE, les 128 octets sont omis :
+ * le bloc est codé avec la table du bloc précédent (lui-même HF_CODEC_HUFF).
+ * Avec HF_BLOCK_4STREAMS (blocs d'au moins HF_STREAMS_MIN octets), le flux
+ * est remplacé par 3 x u32 (tailles en octets des flux 0 à 2, big-endian)
+ * suivis de 4 flux indépendants codant chacun un quart consécutif du bloc
+ * ((n + 3) / 4 symboles, le dernier quart éventuellement plus court) : le
+ * décodeur avance sur les 4 à la fois.
+ *
+ * Charge utile HF_CODEC_PAIRS :
+ *   128 octets : longueurs des 256 octets (comme HF_CODEC_HUFF)
+ *   u16 K      : nombre de paires (1..HF_PAIRS_MAX), big-endian
+ *   K*2 octets : les paires (premier octet, second octet), ordre croissant
+ *   (K+1)/2 octets : longueurs des paires, 4 bits chacune (0 interdit)
+ *   flux de bits ; le symbole 256+j produit les deux octets de la paire j.
+ * Seules les paires effectivement codées sont listées (table creuse).
+ *
+ * Charge utile HF_CODEC_LZ :
+ *   143 octets : longueurs des 285 symboles littéral/longueur, 4 bits chacune
+ *                (0..255 : octet, 256 + c : code de longueur c de deflate)
+ *   15 octets  : longueurs des 30 codes de distance, 4 bits chacune
+ *   flux de bits : par séquence, le code littéral/longueur ; pour une
+ *   correspondance, suivi de ses bits supplémentaires de longueur, du code de
+ *   distance et de ses bits supplémentaires (valeurs MSB-first).
+ *
+ * Charge utile HF_CODEC_BWT :
+ *   u32 primary : indice du sentinelle dans la colonne L (big-endian)
+ *   129 octets  : longueurs des 257 symboles, 4 bits chacune
+ *                 (0 = RUNA, 1 = RUNB, r + 1 = rang move-to-front r)
+ *   flux de bits ; une suite de zéros MTF de longueur k est écrite en base 2
+ *   bijective, chiffre de poids faible d'abord (RUNA = 1, RUNB = 2).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HF_CODEC_STORED   0
+#define HF_CODEC_HUFF     1
+#define HF_CODEC_PAIRS    2
+#define HF_CODEC_LZ       3
+#define HF_CODEC_BWT      4
+
+#define HF_MAX_CODE_LEN   12
+#define HF_TABLE_MIN_BITS 8    /* largeur minimale des tables de décodage */
+#define HF_TABLE_BYTES    128
+#define HF_PAIRS_MAX      256
+
+/* Taille de bloc conseillée pour HF_CODEC_BWT (le taux croît avec le bloc). */
+#define HF_BWT_BLOCK_SIZE (1024u * 1024u)
+
+/* Drapeau de bloc (octet flags de l'en-tête de bloc HUF2) : charge utile
+ * HF_CODEC_HUFF sans table, celle du bloc précédent est reprise. */
+#define HF_BLOCK_REUSE_TABLE 0x01
+
+/* Reprise de table sans construire d'arbre : acceptée si elle coûte au plus
+ * cette fraction de plus que la borne d'entropie d'une nouvelle table (voir
+ * codec_encode_block). 0 : seulement si la reprise est sûrement gagnante. */
+#ifndef HF_REUSE_TOLERANCE
+#define HF_REUSE_TOLERANCE 0.01
+#endif
+
+/* Drapeau de bloc : charge utile HF_CODEC_HUFF en 4 flux entrelacés. */
+#define HF_BLOCK_4STREAMS    0x02
+/* Blocs plus petits : un seul flux. Redéfinissable à la compilation
+ * (-DHF_STREAMS_MIN=...) : make bench s'en sert pour produire des archives
+ * à un seul flux et comparer les deux boucles de décodage. */
+#ifndef HF_STREAMS_MIN
+#define HF_STREAMS_MIN       (16u * 1024u)
+#endif
+#define HF_STREAMS_HEADER    12              /* tailles des flux 0 à 2 */
+
+/* Table Huffman d'ordre 0 du dernier bloc HF_CODEC_HUFF d'une suite de blocs,
+ * transmise d'un appel à l'autre (un contexte pour l'encodeur, un pour le
+ * décodeur). Elle est invalidée par tout bloc d'un autre codec.
+ */
+typedef struct CodecTable {
+    int valide;
+    unsigned char lens[256];
+    uint32_t codes[256];                  /* encodage */
+    uint32_t dec[1 << HF_MAX_CODE_LEN];   /* décodage : construite une fois par table */
+    int bits;
+} CodecTable;
+
+/* Oublie la table (début d'une suite de blocs indépendante). */
+void codec_table_reset(CodecTable *t);
+
+/* Charge dans t (côté décodeur) la table des HF_TABLE_BYTES premiers octets
+ * d'une charge utile HF_CODEC_HUFF sans HF_BLOCK_REUSE_TABLE : sert à reprendre
+ * le décodage au milieu d'une suite (accès aléatoire, segments parallèles).
+ * Retourne 0 si OK, -1 si la table est invalide.
+ */
+int codec_table_load(CodecTable *t, const unsigned char *table);
+
+/* Taille maximale de la charge utile d'un bloc de n octets (jamais plus que stocké). */
+size_t codec_bound(size_t n);
+
+/* Encode src[0..n) dans dst (capacité dst_cap >= codec_bound(n) + 16).
+ * prefere : codec demandé (HF_CODEC_HUFF, _PAIRS, _LZ ou _BWT). Un
+ * codec autre que HF_CODEC_HUFF n'est retenu que s'il est plus petit que lui ;
+ * dans tous les cas le bloc est stocké si rien ne gagne.
+ * niveau : effort de la recherche LZ77 (LZ_LEVEL_MIN..LZ_LEVEL_MAX, lz77.h).
+ * tab : table du bloc précédent (NULL : blocs indépendants). Si elle code
+ * l'histogramme du bloc pour moins cher qu'une nouvelle table plus son
+ * en-tête, à HF_REUSE_TOLERANCE près de la borne d'entropie, le bloc est
+ * marqué HF_BLOCK_REUSE_TABLE ; tab est mise à jour.
+ * Retourne 0 si OK (codec, drapeaux de bloc et taille de la charge utile dans
+ * *out_codec / *out_flags / *out_len), -1 en cas d'erreur.
+ * out_entropy (peut être NULL) reçoit l'entropie d'ordre 0 de src en bits par
+ * octet, tirée de l'histogramme que l'encodeur calcule de toute façon.
+ */
+int codec_encode_block(const unsigned char *src, size_t n,
+                       unsigned char *dst, size_t dst_cap, int prefere, int niveau,
+                       CodecTable *tab, int *out_codec, int *out_flags, size_t *out_len,
+                       double *out_entropy);
+
+/* Décode une charge utile de 'len' octets produite par codec_encode_block
+ * vers dst (exactement raw_size octets). tab : table du bloc précédent,
+ * requise pour un bloc HF_BLOCK_REUSE_TABLE (NULL sinon possible).
+ * Retourne 0 si OK, -1 si corrompue.
+ */
+int codec_decode_block(int codec, int flags, const unsigned char *payload, size_t len,
+                       unsigned char *dst, size_t raw_size, CodecTable *tab);
+
+#endif /* CODEC_H */
@@ -0,0 +1,70 @@
+/*
+ * decode_tmpl.h
+ *
+ * Noyaux de décodage HF_CODEC_HUFF spécialisés. Ce fichier n'a pas de garde
+ * d'inclusion : codec.c l'inclut une fois par combinaison après avoir défini
+ *   DK_BITS     largeur de la table de décodage (8..HF_MAX_CODE_LEN bits)
+ *   DK_STREAMS  nombre de flux entrelacés (1 ou 4)
+ *
+ * Avec une largeur constante, un seul chargement de 64 bits (57 bits utiles
+ * au moins) suffit pour DK_K = 57 / DK_BITS symboles : la boucle interne est
+ * déroulée par le compilateur et le décalage de la table est immédiat. Avec
+ * 4 flux, les 4 chaînes de dépendances (position -> chargement -> table ->
+ * position) progressent en parallèle dans le pipeline. Les derniers octets
+ * de chaque flux passent par decoder_queue() (chargements bornés).
+ */
+
+#define DK_CAT_(a, b, c) decoder_huff_##a##_##b##c
+#define DK_CAT(a, b, c)  DK_CAT_(a, b, c)
+#define DK_NAME          DK_CAT(DK_BITS, DK_STREAMS, f)
+#define DK_K             (57 / DK_BITS)
+
+static int DK_NAME(const uint32_t *table, const unsigned char *const *flux, const size_t *tailles,
+                   unsigned char *dst, size_t n) {
+    unsigned char *d[DK_STREAMS];
+    size_t cnt[DK_STREAMS], pos[DK_STREAMS];
+    size_t q = (DK_STREAMS == 1) ? n : (n + 3) / 4;
+    size_t commun = n;   /* symboles décodables dans tous les flux */
+    for (int s = 0; s < DK_STREAMS; ++s) {
+        size_t debut = (size_t) s * q;
+        d[s] = dst + ((debut < n) ? debut : n);
+        cnt[s] = (debut < n) ? ((n - debut < q) ? n - debut : q) : 0;
+        pos[s] = 0;
+        if (cnt[s] < commun) commun = cnt[s];
+        if (tailles[s] < 8) commun = 0;
+    }
+
+    size_t i = 0;
+    int ok = 1;
+    for (; ok && i + DK_K <= commun; i += DK_K) {
+        uint64_t w[DK_STREAMS];
+        for (int s = 0; s < DK_STREAMS; ++s) {
+            if ((pos[s] >> 3) > tailles[s] - 8) ok = 0;
+        }
+        if (!ok) break;
+        for (int s = 0; s < DK_STREAMS; ++s) {
+            w[s] = bk_load_be64(flux[s] + (pos[s] >> 3)) << (pos[s] & 7);
+        }
+        for (int k = 0; k < DK_K; ++k) {
+            for (int s = 0; s < DK_STREAMS; ++s) {
+                uint32_t e = table[w[s] >> (64 - DK_BITS)];
+                if ((e & 15) == 0) return -1;
+                d[s][i + k] = (unsigned char) (e >> 4);
+                w[s] <<= e & 15;
+                pos[s] += e & 15;
+            }
+        }
+    }
+
+    for (int s = 0; s < DK_STREAMS; ++s) {
+        if (decoder_queue(table, DK_BITS, flux[s], tailles[s], pos[s], d[s] + i, cnt[s] - i) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#undef DK_CAT_
+#undef DK_CAT
+#undef DK_NAME
+#undef DK_K
@@ -0,0 +1,25 @@
+#ifndef HASH_H
+#define HASH_H
+
+/*
+ * hash.h
+ *
+ * Fonctions de hachage non cryptographiques utilisées par le conteneur :
+ * - xxh64  : xxHash64 (identification des chunks de la déduplication,
+ *            somme de contrôle optionnelle des blocs) ;
+ * - crc32c : CRC-32C (Castagnoli), somme de contrôle par défaut des blocs.
+ *            Instruction crc32 de SSE4.2 si le CPU la fournit (choix unique
+ *            au premier appel, HUFFMAN_KERNEL=scalar force le repli),
+ *            sinon table "slicing-by-8".
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* xxHash64 de data[0..len) avec la graine seed (résultat identique à la référence). */
+uint64_t xxh64(const void *data, size_t len, uint64_t seed);
+
+/* CRC-32C de data[0..len) (crc32c("123456789") == 0xE3069283). */
+uint32_t crc32c(const void *data, size_t len);
+
+#endif /* HASH_H */
@@ -15,6 +15,7 @@
  * } Noeud;
  */
 #include "huffman.h"
+#include "alloc.h"
 
 
 /* fonctions utilitaires internes */
@@ -29,7 +30,7 @@ static void swap_noeuds(Noeud **a, Noeud **b) {
 /* doubler la capacité du tas; retourne 0 si OK, -1 si erreur */
 static int agrandir_tas(TasMin *tas) {
     int nouvelle = (tas->capacite == 0) ? 4 : tas->capacite * 2;
-    Noeud **tmp = (Noeud**) realloc(tas->tab, sizeof(Noeud*) * nouvelle);
+    Noeud **tmp = (Noeud**) hf_realloc(tas->tab, sizeof(Noeud*) * nouvelle);
     if (!tmp) return -1;
     tas->tab = tmp;
     tas->capacite = nouvelle;
@@ -44,13 +45,13 @@ static inline int droite_idx(int i) { return 2 * i + 2; }
 /*API publique*/
 
 TasMin* creer_tas_min(int capacite_initiale) {
-    TasMin *tas = (TasMin*) malloc(sizeof(TasMin));
+    TasMin *tas = (TasMin*) hf_malloc(sizeof(TasMin));
     if (!tas) return NULL;
     tas->taille = 0;
     tas->capacite = (capacite_initiale > 0) ? capacite_initiale : 4;
-    tas->tab = (Noeud**) malloc(sizeof(Noeud*) * tas->capacite);
+    tas->tab = (Noeud**) hf_malloc(sizeof(Noeud*) * tas->capacite);
     if (!tas->tab) {
-        free(tas);
+        hf_free(tas);
         return NULL;
     }
     return tas;
@@ -58,8 +59,8 @@ TasMin* creer_tas_min(int capacite_initiale) {
 
 void detruire_tas(TasMin *tas) {
     if (!tas) return;
-    free(tas->tab);
-    free(tas);
+    hf_free(tas->tab);
+    hf_free(tas);
 }
 
 int taille_tas(const TasMin *tas) {
@@ -13,13 +13,14 @@
 
 #include "huffman.h"
 #include "heap.h"    /* API du tas : creer_tas_min, inserer_tas, extraire_min, detruire_tas, taille_tas */
+#include "alloc.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <limits.h> /* pour CHAR_BIT, si nécessaire */
 static char* my_strdup(const char* s) {
     size_t len = strlen(s) + 1;
-    char* copy = malloc(len);
+    char* copy = hf_malloc(len);
     if (copy) memcpy(copy, s, len);
     return copy;
 }
@@ -27,8 +28,8 @@ static char* my_strdup(const char* s) {
 
 /* ---------- Création / destruction de noeuds ---------- */
 
-Noeud* creer_noeud(unsigned char c, unsigned long freq, Noeud *left, Noeud *right) {
-    Noeud *n = (Noeud*) malloc(sizeof(Noeud));
+Noeud* creer_noeud(unsigned int c, unsigned long freq, Noeud *left, Noeud *right) {
+    Noeud *n = (Noeud*) hf_malloc(sizeof(Noeud));
     if (!n) return NULL;
     n->c = c;
     n->freq = freq;
@@ -43,7 +44,7 @@ void detruire_arbre(Noeud *root) {
     if (!root) return;
     detruire_arbre(root->left);
     detruire_arbre(root->right);
-    free(root);
+    hf_free(root);
 }
 
 /* ---------- Construction de l'arbre de Huffman ---------- */
@@ -61,15 +62,19 @@ void detruire_arbre(Noeud *root) {
  *    Si le tas a un seul élément -> extrait et retourne cet élément (racine)
  */
 Noeud* construire_arbre_huffman(const unsigned long freq_table[256]) {
-    if (!freq_table) return NULL;
+    return construire_arbre_huffman_n(freq_table, 256);
+}
+
+Noeud* construire_arbre_huffman_n(const unsigned long *freq_table, int nsym) {
+    if (!freq_table || nsym < 1 || nsym > HUFFMAN_MAX_SYMBOLES) return NULL;
 
     TasMin *tas = creer_tas_min(16);
     if (!tas) return NULL;
 
     /* Étape 1 : insérer toutes les feuilles (symboles existants) */
-    for (int i = 0; i < 256; ++i) {
+    for (int i = 0; i < nsym; ++i) {
         if (freq_table[i] > 0) {
-            Noeud *leaf = creer_noeud((unsigned char)i, freq_table[i], NULL, NULL);
+            Noeud *leaf = creer_noeud((unsigned int)i, freq_table[i], NULL, NULL);
             if (!leaf) {
                 /* en cas d'erreur d'allocation : cleanup et sortie */
                 detruire_tas(tas);
@@ -162,7 +167,7 @@ static void generer_codes_rec(const Noeud *node, char *buf, int depth, char **co
         /* feuille : terminer la chaîne et la dupliquer */
         if (depth == 0) {
             /* cas spécial : arbre réduit à une seule feuille -> convention : code "0" */
-            codes[node->c] = (char*) malloc(2);
+            codes[node->c] = (char*) hf_malloc(2);
             if (codes[node->c]) {
                 codes[node->c][0] = '0';
                 codes[node->c][1] = '\0';
@@ -188,7 +193,7 @@ static void generer_codes_rec(const Noeud *node, char *buf, int depth, char **co
  */
 char** generer_codes(const Noeud *root) {
     /* allouer tableau 256 pointeurs initialisés à NULL */
-    char **codes = (char**) calloc(256, sizeof(char*));
+    char **codes = (char**) hf_calloc(256, sizeof(char*));
     if (!codes) return NULL;
 
     if (!root) return codes; /* vide : tableau rempli de NULL */
@@ -211,11 +216,117 @@ void liberer_codes(char **codes) {
     if (!codes) return;
     for (int i = 0; i < 256; ++i) {
         if (codes[i]) {
-            free(codes[i]);
+            hf_free(codes[i]);
             codes[i] = NULL;
         }
     }
-    free(codes);
+    hf_free(codes);
+}
+
+/* ---------- Longueurs et codes canoniques ---------- */
+
+static void longueurs_codes_rec(const Noeud *node, int depth, unsigned char *lens) {
+    if (!node) return;
+    if (node->leaf) {
+        lens[node->c] = (unsigned char) (depth > 255 ? 255 : depth);
+        return;
+    }
+    longueurs_codes_rec(node->left, depth + 1, lens);
+    longueurs_codes_rec(node->right, depth + 1, lens);
+}
+
+void longueurs_codes(const Noeud *root, unsigned char lens[256]) {
+    longueurs_codes_n(root, lens, 256);
+}
+
+void longueurs_codes_n(const Noeud *root, unsigned char *lens, int nsym) {
+    memset(lens, 0, (size_t) nsym);
+    if (!root) return;
+    if (root->leaf) {
+        lens[root->c] = 1; /* même convention que generer_codes : code "0" */
+        return;
+    }
+    longueurs_codes_rec(root, 0, lens);
+}
+
+int limiter_longueurs(unsigned char lens[256], const unsigned long freq_table[256], int max_len) {
+    return limiter_longueurs_n(lens, freq_table, 256, max_len);
+}
+
+int limiter_longueurs_n(unsigned char *lens, const unsigned long *freq_table, int nsym, int max_len) {
+    if (!lens || !freq_table || nsym < 1 || nsym > HUFFMAN_MAX_SYMBOLES) return -1;
+    if (max_len < 1 || max_len > 32) return -1;
+
+    /* symboles présents, triés par fréquence croissante (tri par insertion :
+     * quelques centaines de symboles au plus en pratique) */
+    int ordre[HUFFMAN_MAX_SYMBOLES];
+    int n = 0;
+    for (int i = 0; i < nsym; ++i) {
+        if (lens[i] == 0) continue;
+        int j = n++;
+        while (j > 0 && freq_table[ordre[j - 1]] > freq_table[i]) {
+            ordre[j] = ordre[j - 1];
+            j--;
+        }
+        ordre[j] = i;
+    }
+    if (max_len < 31 && n > (1 << max_len)) return -1;
+
+    /* somme de Kraft exprimée en unités de 2^-max_len */
+    const uint64_t capacite = 1ULL << max_len;
+    uint64_t kraft = 0;
+    for (int k = 0; k < n; ++k) {
+        int s = ordre[k];
+        if (lens[s] > max_len) lens[s] = (unsigned char) max_len;
+        kraft += 1ULL << (max_len - lens[s]);
+    }
+
+    /* trop de codes courts : allonger les moins fréquents */
+    while (kraft > capacite) {
+        for (int k = 0; k < n && kraft > capacite; ++k) {
+            int s = ordre[k];
+            if (lens[s] < max_len) {
+                lens[s]++;
+                kraft -= 1ULL << (max_len - lens[s]);
+            }
+        }
+    }
+
+    /* place libre : raccourcir les plus fréquents tant que Kraft le permet */
+    int change = 1;
+    while (change) {
+        change = 0;
+        for (int k = n - 1; k >= 0; --k) {
+            int s = ordre[k];
+            if (lens[s] > 1 && kraft + (1ULL << (max_len - lens[s])) <= capacite) {
+                kraft += 1ULL << (max_len - lens[s]);
+                lens[s]--;
+                change = 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void codes_canoniques(const unsigned char lens[256], uint32_t codes[256]) {
+    codes_canoniques_n(lens, codes, 256);
+}
+
+void codes_canoniques_n(const unsigned char *lens, uint32_t *codes, int nsym) {
+    unsigned int nb_par_longueur[33] = {0};
+    uint32_t prochain[33] = {0};
+
+    for (int i = 0; i < nsym; ++i) {
+        if (lens[i] > 0 && lens[i] <= 32) nb_par_longueur[lens[i]]++;
+    }
+    uint32_t code = 0;
+    for (int l = 1; l <= 32; ++l) {
+        code = (code + nb_par_longueur[l - 1]) << 1;
+        prochain[l] = code;
+    }
+    for (int i = 0; i < nsym; ++i) {
+        codes[i] = (lens[i] > 0 && lens[i] <= 32) ? prochain[lens[i]]++ : 0;
+    }
 }
 
 /*Comptage de fréquences depuis un fichier  */
@@ -254,7 +365,7 @@ void afficher_arbre_recursive(const Noeud *node, int depth) {
     for (int i = 0; i < depth; ++i) putchar(' ');
     if (node->leaf) {
         /* afficher l'octet en tant qu'entier et (si imprimable) en caractère */
-        unsigned char ch = node->c;
+        unsigned int ch = node->c;
         if (ch >= 32 && ch <= 126) {
             printf("leaf '%c' (0x%02X) : freq=%lu\n", ch, ch, node->freq);
         } else {
@@ -2,13 +2,17 @@
 #define HUFFMAN_H
 
 #include <stddef.h> /* pour size_t */
+#include <stdint.h> /* pour uint32_t */
+
+/* Taille maximale de l'alphabet (octets, paires d'octets, symboles étendus) */
+#define HUFFMAN_MAX_SYMBOLES 4096
 
 /* Définition d'un noeud d'arbre Huffman.
  * - si leaf == 1, alors 'c' est valide et left/right sont NULL
  * - si leaf == 0, alors noeud interne : c non significatif, freq = somme des fréquences enfants
  */
 typedef struct Noeud {
-    unsigned char c;         /* symbole (0..255) pour les feuilles */
+    unsigned int c;          /* symbole (0..nsym-1, octet pour HUF1) pour les feuilles */
     unsigned long freq;      /* fréquence / poids */
     struct Noeud *left;      /* fils gauche (0) */
     struct Noeud *right;     /* fils droit (1) */
@@ -21,7 +25,7 @@ typedef struct Noeud {
 /* Crée un nouveau Noeud (feuille si left==right==NULL, sinon noeud interne).
  * Retourne NULL si l'allocation échoue.
  */
-Noeud* creer_noeud(unsigned char c, unsigned long freq, Noeud *left, Noeud *right);
+Noeud* creer_noeud(unsigned int c, unsigned long freq, Noeud *left, Noeud *right);
 
 /* Libère récursivement un arbre (post-order). */
 void detruire_arbre(Noeud *root);
@@ -39,6 +43,11 @@ void detruire_arbre(Noeud *root);
  */
 Noeud* construire_arbre_huffman(const unsigned long freq_table[256]);
 
+/* Variante pour un alphabet de nsym symboles (1..HUFFMAN_MAX_SYMBOLES),
+ * ex. octets + paires d'octets fréquentes. Même comportement.
+ */
+Noeud* construire_arbre_huffman_n(const unsigned long *freq_table, int nsym);
+
 /* Génère un tableau de codes (chaînes C) pour chaque octet.
  * - Retourne un tableau alloué de 256 pointeurs (char*). Chaque entrée est soit
  *   NULL (symbole absent) soit une chaîne NUL-terminée contenant '0'/'1'.
@@ -51,6 +60,30 @@ char** generer_codes(const Noeud *root);
 /* Libère le tableau renvoyé par generer_codes (chaînes + tableau). */
 void liberer_codes(char **codes);
 
+/* Codes canoniques (format HUF2)
+ *
+ * Le format par blocs ne stocke que les longueurs de code ; les codes sont
+ * reconstruits de façon canonique (ordre longueur puis symbole, comme deflate).
+ */
+
+/* Remplit lens[256] avec la profondeur de chaque feuille de l'arbre (0 = absent).
+ * Un arbre réduit à une feuille donne une longueur de 1 (code "0").
+ */
+void longueurs_codes(const Noeud *root, unsigned char lens[256]);
+void longueurs_codes_n(const Noeud *root, unsigned char *lens, int nsym);
+
+/* Ramène toutes les longueurs à max_len au plus en conservant un code préfixe
+ * valide (inégalité de Kraft) : les symboles les moins fréquents sont allongés
+ * en priorité, puis les plus fréquents raccourcis s'il reste de la place.
+ * Retourne 0 si OK, -1 si impossible (plus de 2^max_len symboles).
+ */
+int limiter_longueurs(unsigned char lens[256], const unsigned long freq_table[256], int max_len);
+int limiter_longueurs_n(unsigned char *lens, const unsigned long *freq_table, int nsym, int max_len);
+
+/* Calcule les codes canoniques (alignés à droite) à partir des longueurs. */
+void codes_canoniques(const unsigned char lens[256], uint32_t codes[256]);
+void codes_canoniques_n(const unsigned char *lens, uint32_t *codes, int nsym);
+
 /* Compte les fréquences d'un fichier binaire (octet par octet).
  * - path : chemin du fichier
  * - freq_table : tableau sur 256 cases (doit être alloué par l'appelant)
@@ -0,0 +1,284 @@
+/*
+ * inspect.c
+ *
+ * Mode inspection (voir inspect.h) : tout est déduit des en-têtes, de l'index
+ * et des tables de codes ; aucune charge utile n'est décodée.
+ */
+
+#define _POSIX_C_SOURCE 200809L   /* fseeko */
+#define _FILE_OFFSET_BITS 64
+
+#include "inspect.h"
+#include "archive.h"
+#include "codec.h"
+#include "huffman.h"
+#include "io.h"
+#include "alloc.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* Longueurs de code vues dans les tables lues (toutes tables confondues). */
+typedef struct Longueurs {
+    uint64_t codes[256];       /* nombre de codes de chaque longueur */
+    unsigned char vus[256];    /* symboles codés par au moins une table */
+    int profondeur;            /* plus longue longueur rencontrée */
+    uint32_t tables;
+} Longueurs;
+
+static void compter_longueurs(Longueurs *l, const unsigned char lens[256]) {
+    for (int c = 0; c < 256; ++c) {
+        if (lens[c] == 0) continue;
+        l->codes[lens[c]]++;
+        l->vus[c] = 1;
+        if (lens[c] > l->profondeur) l->profondeur = lens[c];
+    }
+    l->tables++;
+}
+
+static int symboles_codes(const unsigned char lens[256]) {
+    int n = 0;
+    for (int c = 0; c < 256; ++c) n += (lens[c] != 0);
+    return n;
+}
+
+static int profondeur(const unsigned char lens[256]) {
+    int p = 0;
+    for (int c = 0; c < 256; ++c) {
+        if (lens[c] > p) p = lens[c];
+    }
+    return p;
+}
+
+static double pourcent(uint64_t a, uint64_t b) {
+    return b ? 100.0 * (double) a / (double) b : 0.0;
+}
+
+static void afficher_longueurs(FILE *out, const Longueurs *l) {
+    int symboles = 0;
+    for (int c = 0; c < 256; ++c) symboles += l->vus[c];
+    fprintf(out, "  symboles          : %d\n", symboles);
+    fprintf(out, "  longueurs de code :");
+    for (int k = 1; k <= l->profondeur; ++k) {
+        if (l->codes[k]) fprintf(out, " %d:%llu", k, (unsigned long long) l->codes[k]);
+    }
+    fprintf(out, "\n");
+    fprintf(out, "  profondeur max    : %d bits\n", l->profondeur);
+}
+
+/* ---------- HUF1 ---------- */
+
+static int inspecter_huf1(FILE *f, const char *path, uint64_t taille, FILE *out) {
+    uint64_t total;
+    unsigned long freq[256];
+    if (read_freq_header(f, &total, freq) != 0) return -1;
+
+    /* mêmes longueurs que l'arbre reconstruit par decompress_file_ex */
+    unsigned char lens[256];
+    memset(lens, 0, sizeof(lens));
+    if (total > 0) {
+        Noeud *root = construire_arbre_huffman(freq);
+        if (!root) return -1;
+        longueurs_codes(root, lens);
+        detruire_arbre(root);
+    }
+
+    Longueurs l;
+    memset(&l, 0, sizeof(l));
+    compter_longueurs(&l, lens);
+    double bits = 0.0, h = 0.0;
+    for (int c = 0; c < 256; ++c) {
+        if (freq[c] == 0) continue;
+        double p = (double) freq[c] / (double) total;
+        bits += p * lens[c];
+        h -= p * log2(p);
+    }
+
+    fprintf(out, "%s : HUF1\n", path);
+    fprintf(out, "  taille d'origine  : %llu octets\n", (unsigned long long) total);
+    fprintf(out, "  taille compressée : %llu octets (%.2f %%)\n", (unsigned long long) taille,
+            pourcent(taille, total));
+    afficher_longueurs(out, &l);
+    fprintf(out, "  bits par symbole  : %.3f (entropie d'ordre 0 : %.3f)\n", bits, h);
+    return 0;
+}
+
+/* ---------- HUF2 ---------- */
+
+static const char *nom_codec(int codec) {
+    switch (codec) {
+        case HF_CODEC_STORED: return "stocké";
+        case HF_CODEC_HUFF: return "huff";
+        case HF_CODEC_PAIRS: return "pairs";
+        case HF_CODEC_LZ: return "lz";
+        case HF_CODEC_BWT: return "bwt";
+        case HF2_TAG_REF: return "ref";
+        default: return "?";
+    }
+}
+
+static const char *nom_checksum(int file_flags) {
+    if (file_flags & HF2_FLAG_XXH64) return "xxh64";
+    if (file_flags & HF2_FLAG_CRC32C) return "crc32c";
+    return "sans somme de contrôle";
+}
+
+static double entropie(const HfIndexEntry *e) {
+    return (double) (e->entropy & ~HF2_ENTROPY_KNOWN) / HF2_ENTROPY_SCALE;
+}
+
+/* Lit la table (128 octets en tête de charge utile) du bloc e. */
+static int lire_table(FILE *f, int file_flags, const HfIndexEntry *e, unsigned char lens[256]) {
+    unsigned char t[HF_TABLE_BYTES];
+    uint64_t pos = e->offset + archive_block_header_size(file_flags);
+    if (e->payload_size < HF_TABLE_BYTES || fseeko(f, (off_t) pos, SEEK_SET) != 0 ||
+        fread(t, 1, sizeof(t), f) != sizeof(t)) return -1;
+    for (int i = 0; i < HF_TABLE_BYTES; ++i) {
+        lens[2 * i] = (unsigned char) (t[i] >> 4);
+        lens[2 * i + 1] = (unsigned char) (t[i] & 0x0F);
+    }
+    return 0;
+}
+
+static int inspecter_huf2(FILE *f, const char *path, uint64_t taille, FILE *out) {
+    HfIndex idx;
+    if (archive_read_index(f, &idx) != 0) return -1;
+
+    /* symboles et profondeur de la table de chaque bloc huff (0 : sans objet) */
+    uint16_t *symb = (uint16_t*) hf_calloc(idx.count ? idx.count : 1, sizeof(uint16_t));
+    unsigned char *prof = (unsigned char*) hf_calloc(idx.count ? idx.count : 1, 1);
+    int rc = (symb && prof) ? 0 : -1;
+
+    Longueurs l;
+    memset(&l, 0, sizeof(l));
+    uint32_t par_codec[256];
+    memset(par_codec, 0, sizeof(par_codec));
+    uint64_t charge = 0, brut = 0;          /* blocs codés dans l'archive (hors références) */
+    uint64_t charge_h = 0, brut_h = 0;      /* ... dont l'entropie est connue */
+    uint64_t brut_connu = 0;                /* tous blocs d'entropie connue */
+    double somme_h = 0.0, somme_hb = 0.0;   /* entropie * taille brute (tous, codés) */
+    uint32_t connus = 0;
+    unsigned char lens[256];
+    int table = 0;   /* lens : table du dernier bloc huff qui en porte une */
+    for (uint32_t i = 0; rc == 0 && i < idx.count; ++i) {
+        const HfIndexEntry *e = &idx.entries[i];
+        const int h_connue = (e->entropy & HF2_ENTROPY_KNOWN) != 0;
+        par_codec[e->codec]++;
+        if (h_connue) {
+            connus++;
+            brut_connu += e->raw_size;
+            somme_h += entropie(e) * e->raw_size;
+        }
+        if (e->codec != HF2_TAG_REF) {
+            charge += e->payload_size;
+            brut += e->raw_size;
+            if (h_connue) {
+                charge_h += e->payload_size;
+                brut_h += e->raw_size;
+                somme_hb += entropie(e) * e->raw_size;
+            }
+        }
+        if (e->codec != HF_CODEC_HUFF) continue;
+        if (!(e->flags & HF_BLOCK_REUSE_TABLE)) {
+            if (lire_table(f, idx.flags, e, lens) != 0) {
+                rc = -1;
+                break;
+            }
+            compter_longueurs(&l, lens);
+            table = 1;
+        }
+        if (table) {
+            symb[i] = (uint16_t) symboles_codes(lens);
+            prof[i] = (unsigned char) profondeur(lens);
+        }
+    }
+    if (rc != 0) {
+        hf_free(symb);
+        hf_free(prof);
+        archive_free_index(&idx);
+        return -1;
+    }
+
+    fprintf(out, "%s : HUF2 (%s%s)\n", path, nom_checksum(idx.flags),
+            (idx.flags & HF2_FLAG_STORE) ? ", magasin de chunks" : "");
+    fprintf(out, "  taille d'origine  : %llu octets\n", (unsigned long long) idx.total_raw);
+    fprintf(out, "  taille compressée : %llu octets (%.2f %%)\n", (unsigned long long) taille,
+            pourcent(taille, idx.total_raw));
+    fprintf(out, "  blocs             : %u", idx.count);
+    const char *sep = " (";
+    for (int c = 0; c < 256; ++c) {
+        if (!par_codec[c]) continue;
+        fprintf(out, "%s%s %u", sep, nom_codec(c), par_codec[c]);
+        sep = ", ";
+    }
+    fprintf(out, "%s\n", idx.count ? ")" : "");
+    if (l.tables > 0) {
+        afficher_longueurs(out, &l);
+        fprintf(out, "  tables huff       : %u\n", l.tables);
+    }
+    if (brut > 0) {
+        fprintf(out, "  bits par octet    : %.3f (charges utiles, tables comprises)\n",
+                8.0 * (double) charge / (double) brut);
+    }
+    if (connus > 0) {
+        double h = brut_connu ? somme_h / (double) brut_connu : 0.0;
+        fprintf(out, "  entropie ordre 0  : %.3f bits par octet (%u/%u blocs)", h, connus, idx.count);
+        if (brut_h > 0 && somme_hb > 0.0) {
+            /* coût réel rapporté à l'entropie, sur les mêmes blocs */
+            double hb = somme_hb / (double) brut_h;
+            fprintf(out, ", écart %+.1f %%", 100.0 * (8.0 * (double) charge_h / (double) brut_h - hb) / hb);
+        }
+        fprintf(out, "\n");
+    } else if (idx.count > 0) {
+        fprintf(out, "  entropie ordre 0  : inconnue\n");
+    }
+    if (idx.count == 0) {
+        hf_free(symb);
+        hf_free(prof);
+        archive_free_index(&idx);
+        return 0;
+    }
+
+    fprintf(out, "  %6s %14s %-7s %3s %10s %10s %7s %8s %5s %4s\n", "bloc", "offset", "codec",
+            "dr.", "brut", "charge", "bits/o", "entropie", "symb", "prof");
+    for (uint32_t i = 0; i < idx.count; ++i) {
+        const HfIndexEntry *e = &idx.entries[i];
+        fprintf(out, "  %6u %14llu %-7s %c%c  %10u %10u ", i, (unsigned long long) e->offset,
+                nom_codec(e->codec), (e->flags & HF_BLOCK_REUSE_TABLE) ? 'r' : '-',
+                (e->flags & HF_BLOCK_4STREAMS) ? '4' : '-', e->raw_size, e->payload_size);
+        if (e->codec != HF2_TAG_REF && e->raw_size > 0) {
+            fprintf(out, "%7.3f ", 8.0 * e->payload_size / e->raw_size);
+        } else {
+            fprintf(out, "%7s ", "-");
+        }
+        if (e->entropy & HF2_ENTROPY_KNOWN) fprintf(out, "%8.3f ", entropie(e));
+        else fprintf(out, "%8s ", "-");
+        if (symb[i]) fprintf(out, "%5u %4u\n", symb[i], prof[i]);
+        else fprintf(out, "%5s %4s\n", "-", "-");
+    }
+
+    hf_free(symb);
+    hf_free(prof);
+    archive_free_index(&idx);
+    return 0;
+}
+
+int inspect_archive(const char *path, FILE *out) {
+    if (!path || !out) return -1;
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    struct stat st;
+    unsigned char magic[4];
+    int rc = -1;
+    if (fstat(fileno(f), &st) == 0 && fread(magic, 1, 4, f) == 4 && fseeko(f, 0, SEEK_SET) == 0) {
+        if (memcmp(magic, HF2_MAGIC, 4) == 0) {
+            rc = inspecter_huf2(f, path, (uint64_t) st.st_size, out);
+        } else if (memcmp(magic, "HUF1", 4) == 0) {
+            rc = inspecter_huf1(f, path, (uint64_t) st.st_size, out);
+        }
+    }
+    fclose(f);
+    return rc;
+}
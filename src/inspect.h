@@ -0,0 +1,27 @@
+#ifndef INSPECT_H
+#define INSPECT_H
+
+/*
+ * inspect.h
+ *
+ * Mode inspection (-i) : statistiques d'une archive sans décoder ses données.
+ * - HUF1 : seul l'en-tête de fréquences est lu (read_freq_header) ; les
+ *   longueurs de code sont celles de l'arbre que reconstruit le décodeur ;
+ * - HUF2 : pied et index (archive_read_index), plus la table de 128 octets
+ *   de chaque bloc HF_CODEC_HUFF qui en porte une. L'entropie de chaque bloc
+ *   vient de l'index (voir archive.h) ; elle est inconnue pour les archives
+ *   écrites avant qu'il ne la contienne.
+ * Quelques lectures par archive, aucune allocation proportionnelle aux
+ * données : de l'ordre de la dizaine de microsecondes par fichier.
+ */
+
+#include <stdio.h>
+
+/* Écrit sur out le rapport d'inspection de l'archive path (HUF1 ou HUF2) :
+ * tailles, symboles, histogramme des longueurs de code, profondeur maximale,
+ * bits par octet comparés à l'entropie d'ordre 0, puis une ligne par bloc.
+ * Retourne 0 si OK, -1 si le fichier est illisible ou d'un format inconnu.
+ */
+int inspect_archive(const char *path, FILE *out);
+
+#endif /* INSPECT_H */
@@ -9,11 +9,18 @@
  * Utilise l'API définie dans huffman.h (construire_arbre_huffman, generer_codes, etc).
  */
 
+#define _POSIX_C_SOURCE 200809L   /* fileno */
+
 #include "io.h"
 #include "huffman.h"
+#include "bitkernels.h"
+#include "archive.h"
+#include "outfile.h"
+#include "alloc.h"
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
 
 /*Helper: écriture / lecture d'entiers 64-bit en big-endian */
 
@@ -40,49 +47,99 @@ static int read_u64_be(FILE *f, uint64_t *out_v) {
 
 BitWriter* bw_create(FILE *out) {
     if (!out) return NULL;
-    BitWriter *bw = (BitWriter*) malloc(sizeof(BitWriter));
+    BitWriter *bw = (BitWriter*) hf_malloc(sizeof(BitWriter));
     if (!bw) return NULL;
+    /* marge de 16 octets : les noyaux font des stores 64 bits au-delà de len */
+    bw->buf = (unsigned char*) hf_malloc(BW_BUFFER_SIZE + 16);
+    if (!bw->buf) {
+        hf_free(bw);
+        return NULL;
+    }
     bw->f = out;
-    bw->buffer = 0;
+    bw->acc = 0;
     bw->bit_count = 0;
+    bw->len = 0;
+    bw->cap = BW_BUFFER_SIZE;
+    bw->owns_buf = 1;
     return bw;
 }
 
-/* Écrit le tampon courant (si bit_count > 0) en complétant par des zéros à droite. */
-void bw_write_flush(BitWriter *bw) {
-    if (!bw) return;
-    if (bw->bit_count == 0) return;
-    /* écrire l'octet (les bits non écrits à droite sont considérés 0) */
-    unsigned char towrite = bw->buffer << (8 - bw->bit_count); /* aligner MSB */
-    fwrite(&towrite, 1, 1, bw->f);
-    bw->buffer = 0;
+BitWriter* bw_create_mem(unsigned char *dst, size_t dst_cap) {
+    if (!dst || dst_cap < 16) return NULL;
+    BitWriter *bw = (BitWriter*) hf_malloc(sizeof(BitWriter));
+    if (!bw) return NULL;
+    bw->f = NULL;
+    bw->buf = dst;
+    bw->acc = 0;
     bw->bit_count = 0;
+    bw->len = 0;
+    bw->cap = dst_cap - 16;
+    bw->owns_buf = 0;
+    return bw;
+}
+
+int bw_drain(BitWriter *bw) {
+    if (!bw) return -1;
+    if (!bw->f) return (bw->len > bw->cap) ? -1 : 0; /* mémoire : rien à vider */
+    if (bw->len == 0) return 0;
+    size_t w = fwrite(bw->buf, 1, bw->len, bw->f);
+    int rc = (w == bw->len) ? 0 : -1; /* écriture partielle : octets perdus */
+    bw->len = 0;
+    return rc;
+}
+
+/* Écrit le tampon puis le dernier octet partiel (si bit_count > 0) en complétant par des zéros à droite. */
+int bw_write_flush(BitWriter *bw) {
+    if (!bw) return -1;
+    if (bw->bit_count > 0) {
+        /* acc est aligné sur le MSB : les bits non écrits à droite sont déjà 0 */
+        if (!bw->f && bw->len >= bw->cap) return -1; /* mémoire pleine : l'octet ne tient plus */
+        bw->buf[bw->len++] = (unsigned char) (bw->acc >> 56);
+        bw->acc = 0;
+        bw->bit_count = 0;
+    }
     /* Ne pas fermer le FILE* ici */
+    return bw_drain(bw);
 }
 
 void bw_destroy(BitWriter *bw) {
     if (!bw) return;
     /* ne pas fermer bw->f ; l'appelant gère FILE* */
-    free(bw);
+    if (bw->owns_buf) hf_free(bw->buf);
+    hf_free(bw);
 }
 
-/* Écrit un bit (0 ou 1). On stocke les bits dans buffer de gauche à droite
- * (MSB first). Ex: premier bit écrit -> position 0 (MSB).
+/* Écrit les 'count' bits de poids faible de value, MSB en premier.
+ * Les bits sont accumulés dans acc (aligné MSB) et les octets complets sont
+ * recopiés d'un seul store 64 bits dans le tampon.
  */
-int bw_write_bit(BitWriter *bw, int bit) {
-    if (!bw) return -1;
-    bit = (bit ? 1 : 0);
-    /* mettre le bit en position (7 - bit_count) pour MSB-first */
-    bw->buffer |= (unsigned char) (bit << (7 - bw->bit_count));
-    bw->bit_count++;
-    if (bw->bit_count == 8) {
-        if (fwrite(&bw->buffer, 1, 1, bw->f) != 1) return -1;
-        bw->buffer = 0;
-        bw->bit_count = 0;
+int bw_write_bits(BitWriter *bw, uint64_t value, int count) {
+    if (!bw || count < 1 || count > 64) return -1;
+    /* découper en morceaux de 32 bits max : acc ne déborde jamais (7 + 32 < 64) */
+    while (count > 0) {
+        int l = (count > 32) ? 32 : count;
+        count -= l;
+        uint64_t chunk = (value >> count) & ((1ULL << l) - 1ULL);
+        bw->acc |= chunk << (64 - bw->bit_count - l);
+        bw->bit_count += l;
+        bk_store_be64(bw->buf + bw->len, bw->acc);
+        int nbytes = bw->bit_count >> 3;
+        bw->len += (size_t) nbytes;
+        bw->acc = (nbytes == 8) ? 0 : (bw->acc << (nbytes * 8));
+        bw->bit_count &= 7;
+        if (bw->len >= bw->cap) {
+            if (bw_drain(bw) != 0) return -1;
+        }
     }
     return 0;
 }
 
+/* Écrit un bit (0 ou 1). Le premier bit écrit occupe le MSB de l'octet. */
+int bw_write_bit(BitWriter *bw, int bit) {
+    if (!bw) return -1;
+    return bw_write_bits(bw, (uint64_t) (bit ? 1 : 0), 1);
+}
+
 /* Écrire une chaîne "010010..." pratique pour écrire un code produit par generer_codes. */
 int bw_write_bits_from_string(BitWriter *bw, const char *bits) {
     if (!bw || !bits) return -1;
@@ -103,26 +160,51 @@ int bw_write_bits_from_string(BitWriter *bw, const char *bits) {
 
 BitReader* br_create(FILE *in) {
     if (!in) return NULL;
-    BitReader *br = (BitReader*) malloc(sizeof(BitReader));
+    BitReader *br = (BitReader*) hf_malloc(sizeof(BitReader));
     if (!br) return NULL;
+    /* marge de 8 octets à zéro : un load 64 bits est toujours possible à bit_pos */
+    br->buf = (unsigned char*) hf_calloc(BR_BUFFER_SIZE + 8, 1);
+    if (!br->buf) {
+        hf_free(br);
+        return NULL;
+    }
     br->f = in;
-    br->buffer = 0;
-    br->bit_pos = -1; /* buffer vide initialement */
+    br->len = 0;
+    br->bit_pos = 0; /* buffer vide initialement */
+    br->eof = 0;
     return br;
 }
 
+/* Décale les octets non lus en tête du tampon et le complète depuis le FILE*. */
+int br_refill(BitReader *br) {
+    if (!br) return -1;
+    if (br->eof) return 0;
+    size_t skip = br->bit_pos >> 3;
+    if (skip > br->len) skip = br->len;
+    if (skip > 0) {
+        memmove(br->buf, br->buf + skip, br->len - skip);
+        br->len -= skip;
+        br->bit_pos -= skip << 3;
+    }
+    size_t r = fread(br->buf + br->len, 1, BR_BUFFER_SIZE - br->len, br->f);
+    if (r < BR_BUFFER_SIZE - br->len) {
+        if (ferror(br->f)) return -1;
+        br->eof = 1;
+    }
+    br->len += r;
+    memset(br->buf + br->len, 0, 8);
+    return 0;
+}
+
 /* Lire un bit (MSB-first). Retourne 0 ou 1, -1 si EOF ou erreur */
 int br_read_bit(BitReader *br) {
     if (!br) return -1;
-    if (br->bit_pos < 0) {
-        unsigned char tmp;
-        size_t r = fread(&tmp, 1, 1, br->f);
-        if (r != 1) return -1; /* EOF ou erreur */
-        br->buffer = tmp;
-        br->bit_pos = 7; /* commencer par le MSB */
+    if (br->bit_pos >= (br->len << 3)) {
+        if (br_refill(br) != 0) return -1;
+        if (br->bit_pos >= (br->len << 3)) return -1; /* EOF */
     }
-    int bit = ( (br->buffer >> br->bit_pos) & 1 );
-    br->bit_pos--;
+    int bit = (br->buf[br->bit_pos >> 3] >> (7 - (br->bit_pos & 7))) & 1;
+    br->bit_pos++;
     return bit;
 }
 
@@ -134,17 +216,25 @@ int br_read_bit(BitReader *br) {
 long long br_read_bits(BitReader *br, int count) {
     if (!br || count < 1 || count > 64) return -1;
     unsigned long long value = 0;
-    for (int i = 0; i < count; ++i) {
-        int b = br_read_bit(br);
-        if (b < 0) return -1;
-        value = (value << 1) | (unsigned long long) b;
+    while (count > 0) {
+        if (!br->eof && br->bit_pos + 64 > (br->len << 3)) {
+            if (br_refill(br) != 0) return -1;
+        }
+        /* au plus 56 bits par load : (bit_pos & 7) + 56 <= 63 */
+        int l = (count > 56) ? 56 : count;
+        if (br->bit_pos + (size_t) l > (br->len << 3)) return -1;
+        uint64_t w = bk_load_be64(br->buf + (br->bit_pos >> 3)) << (br->bit_pos & 7);
+        value = (value << l) | (w >> (64 - l));
+        br->bit_pos += (size_t) l;
+        count -= l;
     }
     return (long long) value;
 }
 
 void br_destroy(BitReader *br) {
     if (!br) return;
-    free(br);
+    hf_free(br->buf);
+    hf_free(br);
 }
 
 /*Header (freq table)*/
@@ -162,12 +252,8 @@ int write_freq_header(FILE *out, uint64_t total_symbols, const unsigned long fre
     return 0;
 }
 
-int read_freq_header(FILE *in, uint64_t *out_total_symbols, unsigned long freq_table[256]) {
-    if (!in || !out_total_symbols || !freq_table) return -1;
-    unsigned char magic[4];
-    if (fread(magic, 1, 4, in) != 4) return -1;
-    if (memcmp(magic, "HUF1", 4) != 0) return -1; /* format invalide */
-
+/* Suite de l'en-tête HUF1 après le magic : total puis 256 fréquences. */
+static int lire_frequences(FILE *in, uint64_t *out_total_symbols, unsigned long freq_table[256]) {
     uint64_t total;
     if (read_u64_be(in, &total) != 0) return -1;
     *out_total_symbols = total;
@@ -180,9 +266,21 @@ int read_freq_header(FILE *in, uint64_t *out_total_symbols, unsigned long freq_t
     return 0;
 }
 
+int read_freq_header(FILE *in, uint64_t *out_total_symbols, unsigned long freq_table[256]) {
+    if (!in || !out_total_symbols || !freq_table) return -1;
+    unsigned char magic[4];
+    if (fread(magic, 1, 4, in) != 4) return -1;
+    if (memcmp(magic, "HUF1", 4) != 0) return -1; /* format invalide */
+    return lire_frequences(in, out_total_symbols, freq_table);
+}
+
 /*Compression haut niveau*/
 
 int compress_file(const char *input_path, const char *output_path) {
+    return archive_compress(input_path, output_path, NULL);
+}
+
+int compress_file_huf1(const char *input_path, const char *output_path) {
     if (!input_path || !output_path) return -1;
 
     /* 1) compter fréquences */
@@ -245,9 +343,38 @@ int compress_file(const char *input_path, const char *output_path) {
         return -1;
     }
 
+    /* Codes sous forme entière pour les noyaux 64 bits (si tous tiennent sur 32 bits) */
+    uint32_t int_codes[256];
+    unsigned char code_lens[256];
+    int use_kernel = 1;
+    for (int i = 0; i < 256; ++i) {
+        int_codes[i] = 0;
+        code_lens[i] = 0;
+        if (!codes[i]) continue;
+        size_t l = strlen(codes[i]);
+        if (l > 32) {
+            use_kernel = 0;
+            break;
+        }
+        for (size_t k = 0; k < l; ++k) int_codes[i] = (int_codes[i] << 1) | (uint32_t) (codes[i][k] == '1');
+        code_lens[i] = (unsigned char) l;
+    }
+    const BitKernels *kernels = bit_kernels();
+
     unsigned char buf[4096];
     size_t r;
     while ((r = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (use_kernel) {
+            if (kernels->encode(bw, buf, r, int_codes, code_lens) != 0) {
+                bw_destroy(bw);
+                fclose(in); fclose(out);
+                liberer_codes(codes);
+                detruire_arbre(root);
+                return -1;
+            }
+            continue;
+        }
+        /* codes de plus de 32 bits (arbre très déséquilibré) : chemin générique */
         for (size_t i = 0; i < r; ++i) {
             unsigned char ch = buf[i];
             const char *code = codes[ch];
@@ -269,28 +396,49 @@ int compress_file(const char *input_path, const char *output_path) {
         }
     }
     /* flush final (pad 0 jusqu'à octet) */
-    bw_write_flush(bw);
+    int rc = bw_write_flush(bw);
     /* cleanup */
     bw_destroy(bw);
     fclose(in);
-    fclose(out);
+    if (fclose(out) != 0) rc = -1;
 
     liberer_codes(codes);
     detruire_arbre(root);
-    return 0;
+    return rc;
 }
 
 /*Décompression*/
 
+/* Sortie HUF1 : symboles décodés par paquets de cette taille avant écriture. */
+#define HF1_OUT_CHUNK (1u << 20)
+
 /* Décodage : lit bits et suit l'arbre jusqu'à feuille, écrit le symbole, répète
  * jusqu'à total_symbols symboles produits.
  */
 int decompress_file(const char *input_path, const char *output_path) {
+    return decompress_file_ex(input_path, output_path, NULL);
+}
+
+int decompress_file_ex(const char *input_path, const char *output_path, const HfOptions *opt) {
     if (!input_path || !output_path) return -1;
 
     FILE *in = fopen(input_path, "rb");
     if (!in) return -1;
 
+    /* HUF2 : conteneur par blocs */
+    unsigned char magic[4];
+    if (fread(magic, 1, 4, in) == 4 && memcmp(magic, HF2_MAGIC, 4) == 0) {
+        FILE *out = fopen(output_path, "wb");
+        if (!out) { fclose(in); return -1; }
+        rewind(in);
+        int rc = archive_decompress_stream(in, out, opt);
+        if (fclose(out) != 0) rc = -1;
+        fclose(in);
+        return rc;
+    }
+    rewind(in);
+
+    /* HUF1 : en-tête de fréquences global */
     uint64_t total_symbols;
     unsigned long freq_table[256];
     if (read_freq_header(in, &total_symbols, freq_table) != 0) {
@@ -307,69 +455,92 @@ int decompress_file(const char *input_path, const char *output_path) {
         return 0;
     }
 
+    /* total_symbols vient du fichier : au moins un bit par symbole, donc au plus
+     * 8 symboles par octet restant. Au-delà, l'en-tête est corrompu et ne doit
+     * pas réserver la place d'un fichier qui ne sera jamais écrit. */
+    struct stat st;
+    long debut = ftell(in);
+    if (debut < 0 || fstat(fileno(in), &st) != 0 ||
+        (S_ISREG(st.st_mode) && total_symbols / 8 > (uint64_t) st.st_size - (uint64_t) debut)) {
+        fclose(in);
+        return -1;
+    }
+
     /* reconstruire arbre */
     Noeud *root = construire_arbre_huffman(freq_table);
     if (!root) { fclose(in); return -1; }
 
-    FILE *out = fopen(output_path, "wb");
-    if (!out) {
+    /* total_symbols est la taille de sortie : fichier préalloué */
+    HfOutput out;
+    if (output_open(&out, output_path, total_symbols) != 0) {
         detruire_arbre(root);
         fclose(in);
         return -1;
     }
 
     BitReader *br = br_create(in);
-    if (!br) {
-        fclose(out);
+    unsigned char *obuf = (unsigned char*) hf_malloc(HF1_OUT_CHUNK);
+    if (!br || !obuf) {
+        br_destroy(br);
+        hf_free(obuf);
+        output_close(&out);
         detruire_arbre(root);
         fclose(in);
         return -1;
     }
 
-    /* Décodage symboles */
+    /* Décodage symboles : par paquets via le noyau actif, puis un pwrite par paquet */
+    const BitKernels *kernels = bit_kernels();
     uint64_t produced = 0;
-    Noeud *cursor = root;
+    int rc = 0;
 
     while (produced < total_symbols) {
-        int b = br_read_bit(br);
-        if (b < 0) {
-            /* EOF prématuré -> erreur */
-            br_destroy(br);
-            fclose(out);
-            detruire_arbre(root);
-            fclose(in);
-            return -1;
+        uint64_t left = total_symbols - produced;
+        size_t n = (left < HF1_OUT_CHUNK) ? (size_t) left : HF1_OUT_CHUNK;
+        if (kernels->decode_tree(br, root, obuf, n) != 0 || output_write(&out, produced, obuf, n) != 0) {
+            /* EOF prématuré ou erreur d'écriture */
+            rc = -1;
+            break;
         }
-
-        /* avancer dans l'arbre : convention gauche=0, droite=1 */
-        if (b == 0) {
-            if (cursor->left) cursor = cursor->left;
-        } else {
-            if (cursor->right) cursor = cursor->right;
-        }
-
-        if (cursor->leaf) {
-            unsigned char ch = cursor->c;
-            if (fwrite(&ch, 1, 1, out) != 1) {
-                br_destroy(br);
-                fclose(out);
-                detruire_arbre(root);
-                fclose(in);
-                return -1;
-            }
-            produced++;
-            cursor = root; /* revenir à la racine pour décoder prochain symbole */
-        }
-        /* cas spécial : si l'arbre est une seule feuille (root->leaf) alors on ignore bits lus
-         * et on doit ré-écrire le même symbole total_symbols fois. Le code ci-dessus
-         * fonctionne si le flux contient au moins un bit (mais en pratique compress_file
-         * écrit le code "0" pour la feuille unique). */
+        produced += n;
     }
 
     /* cleanup */
     br_destroy(br);
-    fclose(out);
+    hf_free(obuf);
+    if (rc == 0 && output_close(&out) != 0) rc = -1;
+    if (rc != 0) output_abort(&out);
     detruire_arbre(root);
     fclose(in);
-    return 0;
+    return rc;
+}
+
+int decompress_stream_huf1(FILE *in, FILE *out) {
+    if (!in || !out) return -1;
+
+    uint64_t total_symbols;
+    unsigned long freq_table[256];
+    if (lire_frequences(in, &total_symbols, freq_table) != 0) return -1;
+    if (total_symbols == 0) return 0;
+
+    Noeud *root = construire_arbre_huffman(freq_table);
+    if (!root) return -1;
+    BitReader *br = br_create(in);
+    unsigned char *obuf = (unsigned char*) hf_malloc(HF1_OUT_CHUNK);
+    int rc = (br && obuf) ? 0 : -1;
+
+    /* même décodage que decompress_file_ex, écrit au fil du flux */
+    const BitKernels *kernels = bit_kernels();
+    uint64_t produced = 0;
+    while (rc == 0 && produced < total_symbols) {
+        uint64_t left = total_symbols - produced;
+        size_t n = (left < HF1_OUT_CHUNK) ? (size_t) left : HF1_OUT_CHUNK;
+        if (kernels->decode_tree(br, root, obuf, n) != 0 || fwrite(obuf, 1, n, out) != n) rc = -1;
+        produced += n;
+    }
+
+    br_destroy(br);
+    hf_free(obuf);
+    detruire_arbre(root);
+    return rc;
 }
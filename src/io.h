@@ -17,32 +17,67 @@
 
 /*BitWriter / BitReader */
 
-/* BitWriter : permet d'écrire des bits dans un FILE* (bufferisé par octet). */
+/* Taille des tampons internes des BitWriter / BitReader (en octets).
+ * Les E/S se font par mots de 64 bits dans ces tampons, puis par gros
+ * blocs fread/fwrite vers le FILE*.
+ */
+#define BW_BUFFER_SIZE (64 * 1024)
+#define BR_BUFFER_SIZE (64 * 1024)
+
+/* BitWriter : permet d'écrire des bits dans un FILE* (bufferisé par mots de 64 bits). */
 typedef struct BitWriter {
     FILE *f;               /* flux de sortie (ouvert pour "wb") */
-    unsigned char buffer;  /* tampon d'octet en construction (bits écrits de MSB->LSB) */
-    int bit_count;         /* nombre de bits valides dans buffer (0..7) */
+    uint64_t acc;          /* bits en attente, alignés sur le MSB (premier bit écrit = bit 63) */
+    int bit_count;         /* nombre de bits valides dans acc (0..7 entre deux appels) */
+    unsigned char *buf;    /* octets complets en attente d'écriture (+ marge pour les stores 64 bits) */
+    size_t len;            /* nombre d'octets valides dans buf */
+    size_t cap;            /* seuil de vidage (FILE*) ou capacité utile (mémoire) de buf */
+    int owns_buf;          /* 1 si buf est alloué par bw_create */
 } BitWriter;
 
-/* BitReader : permet de lire des bits depuis un FILE* (bufferisé par octet). */
+/* BitReader : permet de lire des bits depuis un FILE* (bufferisé par mots de 64 bits). */
 typedef struct BitReader {
     FILE *f;               /* flux d'entrée (ouvert pour "rb") */
-    unsigned char buffer;  /* octet courant */
-    int bit_pos;           /* position du prochain bit à lire (0..7). -1 = buffer vide */
+    unsigned char *buf;    /* octets lus (+ 8 octets de marge à zéro pour les loads 64 bits) */
+    size_t len;            /* nombre d'octets valides dans buf */
+    size_t bit_pos;        /* position (en bits, depuis buf[0]) du prochain bit à lire */
+    int eof;               /* 1 quand le FILE* est épuisé */
 } BitReader;
 
 /* Création / destruction */
 BitWriter* bw_create(FILE *out);
-void bw_write_flush(BitWriter *bw);    /* force l'écriture du dernier octet (avec padding zeros) */
-void bw_destroy(BitWriter *bw);        /* n'appelle pas fclose(out) */
+/* Variante mémoire : écrit directement dans dst (capacité dst_cap, dont 16
+ * octets de marge réservés aux stores 64 bits). Pas de FILE* : dépasser la
+ * capacité est une erreur. Après bw_write_flush, bw->len = taille produite.
+ */
+BitWriter* bw_create_mem(unsigned char *dst, size_t dst_cap);
+/* Force l'écriture du tampon et du dernier octet (avec padding zeros).
+ * Retourne 0 si OK, -1 si écriture incomplète ou capacité mémoire dépassée.
+ */
+int bw_write_flush(BitWriter *bw);
+void bw_destroy(BitWriter *bw);        /* n'appelle pas fclose(out) ; appeler bw_write_flush avant */
+
+/* Écrit vers le FILE* les octets complets du tampon interne.
+ * Utilisé par les noyaux d'encodage (bitkernels.c). Retourne 0 si OK, -1 si
+ * erreur (écriture partielle, ou capacité dépassée en mode mémoire).
+ */
+int bw_drain(BitWriter *bw);
 
 BitReader* br_create(FILE *in);
 int br_read_bit(BitReader *br);        /* retourne 0 ou 1, ou -1 si EOF/error */
 void br_destroy(BitReader *br);        /* n'appelle pas fclose(in) */
 
+/* Recharge le tampon interne depuis le FILE* (conserve les bits non lus).
+ * Utilisé par les noyaux de décodage. Retourne 0 si OK, -1 si erreur de lecture.
+ */
+int br_refill(BitReader *br);
+
 /* Écrire un bit (0/1) ; retourne 0 si OK, -1 si erreur */
 int bw_write_bit(BitWriter *bw, int bit);
 
+/* Écrire les 'count' bits de poids faible de value (1..64), MSB en premier ; retourne 0 si OK */
+int bw_write_bits(BitWriter *bw, uint64_t value, int count);
+
 /* Écrire une séquence de bits fournie comme chaîne "01011..." ; retourne 0 si OK */
 int bw_write_bits_from_string(BitWriter *bw, const char *bits);
 
@@ -67,22 +102,46 @@ int read_freq_header(FILE *in, uint64_t *out_total_symbols, unsigned long freq_t
 /*Compression / Décompression haut-niveau*/
 
 /* compress_file :
+ * - découpe le fichier source en blocs (HF2_DEFAULT_BLOCK_SIZE),
+ * - encode chaque bloc (Huffman canonique ou stocké, voir codec.h),
+ * - écrit une archive HUF2 (blocs + index + pied, voir archive.h).
+ *
+ * Retourne 0 si succès, -1 en cas d'erreur.
+ */
+int compress_file(const char *input_path, const char *output_path);
+
+/* compress_file_huf1 : ancien format à table de fréquences globale.
  * - lit le fichier source, compte les fréquences,
  * - construit l'arbre Huffman, génère les codes,
  * - écrit l'en-tête (table des fréquences + total) puis le flux compressé bit-à-bit.
  *
+ * Conservé pour produire des fichiers lisibles par les anciennes versions.
  * Retourne 0 si succès, -1 en cas d'erreur.
  */
-int compress_file(const char *input_path, const char *output_path);
+int compress_file_huf1(const char *input_path, const char *output_path);
 
 /* decompress_file :
- * - lit l'en-tête (reconstruit la table des fréquences),
- * - reconstruit l'arbre Huffman,
- * - lit le flux de bits et reconstruit exactement total_symbols octets,
+ * - détecte le format (magic "HUF1" ou "HUF2"),
+ * - HUF1 : lit l'en-tête, reconstruit l'arbre Huffman et décode exactement
+ *   total_symbols octets,
+ * - HUF2 : décode les blocs séquentiellement (archive_decompress_stream),
  *   en écrivant dans output_path.
  *
  * Retourne 0 si succès, -1 en cas d'erreur.
  */
 int decompress_file(const char *input_path, const char *output_path);
 
+/* decompress_file avec options (ex: magasin de chunks d'une archive --store).
+ * opt peut être NULL.
+ */
+typedef struct HfOptions HfOptions;
+int decompress_file_ex(const char *input_path, const char *output_path, const HfOptions *opt);
+
+/* Décode un flux HUF1 dont le magic "HUF1" vient d'être lu sur in (entrée
+ * non seekable, ex: stdin) : lit la suite de l'en-tête puis écrit les
+ * total_symbols octets décodés sur out au fil de l'eau.
+ * Retourne 0 si succès, -1 si format invalide / tronqué ou erreur d'E/S.
+ */
+int decompress_stream_huf1(FILE *in, FILE *out);
+
 #endif /* IO_H */
@@ -0,0 +1,170 @@
+/*
+ * lz77.c
+ *
+ * Recherche de correspondances par chaînes de hachage (même principe que
+ * deflate) :
+ * - head[h] : dernière position dont les 3 premiers octets ont le hachage h,
+ * - prev[pos % LZ_WINDOW] : position précédente de même hachage,
+ * - niveaux : nombre de maillons parcourus, longueur "suffisante" qui arrête
+ *   la recherche, et recherche paresseuse (on diffère une correspondance si la
+ *   position suivante en offre une plus longue).
+ */
+
+#include "lz77.h"
+#include "alloc.h"
+#include <stdlib.h>
+
+#define LZ_HASH_BITS 15
+#define LZ_HASH_SIZE (1u << LZ_HASH_BITS)
+#define LZ_WMASK     (LZ_WINDOW - 1)
+
+/* une correspondance de 3 octets lointaine coûte plus cher que 3 littéraux */
+#define LZ_TOO_FAR   4096
+
+typedef struct {
+    int max_chain;   /* maillons parcourus au plus */
+    int nice;        /* longueur à partir de laquelle on s'arrête */
+    int lazy;        /* recherche paresseuse */
+} LzNiveau;
+
+static const LzNiveau niveaux[LZ_LEVEL_MAX + 1] = {
+    {   0,   0, 0 },
+    {   4,  16, 0 },
+    {   8,  32, 0 },
+    {  16,  64, 0 },
+    {  16,  32, 1 },
+    {  32,  64, 1 },
+    {  64, 128, 1 },
+    { 128, 128, 1 },
+    { 512, 258, 1 },
+    {2048, 258, 1 },
+};
+
+typedef struct {
+    const unsigned char *src;
+    size_t n;
+    int32_t *head;
+    int32_t *prev;
+    size_t insere;   /* prochaine position à insérer dans les chaînes */
+    const LzNiveau *niv;
+} LzEtat;
+
+static inline uint32_t hacher(const unsigned char *p) {
+    uint32_t v = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Insère dans les chaînes toutes les positions jusqu'à pos inclus. */
+static inline void inserer_jusqua(LzEtat *z, size_t pos) {
+    size_t lim = (z->n >= LZ_MIN_MATCH) ? z->n - LZ_MIN_MATCH : 0;
+    if (pos > lim) pos = lim;
+    for (; z->insere <= pos; ++z->insere) {
+        uint32_t h = hacher(z->src + z->insere);
+        z->prev[z->insere & LZ_WMASK] = z->head[h];
+        z->head[h] = (int32_t) z->insere;
+    }
+}
+
+/* Longueur commune de a et b, au plus max (comparaison par mots de 8 octets). */
+static inline size_t longueur_commune(const unsigned char *a, const unsigned char *b, size_t max) {
+    size_t l = 0;
+    while (l + 8 <= max) {
+        uint64_t x, y;
+        memcpy(&x, a + l, 8);
+        memcpy(&y, b + l, 8);
+        if (x != y) {
+            while (a[l] == b[l]) l++;
+            return l;
+        }
+        l += 8;
+    }
+    while (l < max && a[l] == b[l]) l++;
+    return l;
+}
+
+/* Meilleure correspondance pour pos (qui est insérée au passage).
+ * Retourne sa longueur (0 si aucune) et sa distance dans *dist.
+ */
+static size_t chercher(LzEtat *z, size_t pos, size_t *dist) {
+    if (pos + LZ_MIN_MATCH > z->n) return 0;
+    inserer_jusqua(z, pos);
+    int32_t cand = z->prev[pos & LZ_WMASK];
+
+    size_t max = z->n - pos;
+    if (max > LZ_MAX_MATCH) max = LZ_MAX_MATCH;
+    const unsigned char *p = z->src + pos;
+    size_t best = 0;
+    int chaine = z->niv->max_chain;
+
+    while (cand >= 0 && chaine-- > 0) {
+        size_t c = (size_t) cand;
+        if (c >= pos || pos - c > LZ_WINDOW - 1) break;
+        const unsigned char *q = z->src + c;
+        if (q[best] == p[best] && q[0] == p[0]) {
+            size_t l = longueur_commune(p, q, max);
+            if (l > best) {
+                best = l;
+                *dist = pos - c;
+                if (l >= (size_t) z->niv->nice || l == max) break;
+            }
+        }
+        int32_t suivant = z->prev[c & LZ_WMASK];
+        if (suivant >= cand) break; /* maillon écrasé par une position plus récente */
+        cand = suivant;
+    }
+    if (best < LZ_MIN_MATCH || (best == LZ_MIN_MATCH && *dist > LZ_TOO_FAR)) return 0;
+    return best;
+}
+
+size_t lz_parse(const unsigned char *src, size_t n, int level, LzToken *out) {
+    if (level < LZ_LEVEL_MIN) level = LZ_LEVEL_MIN;
+    if (level > LZ_LEVEL_MAX) level = LZ_LEVEL_MAX;
+
+    LzEtat z;
+    z.src = src;
+    z.n = n;
+    z.insere = 0;
+    z.niv = &niveaux[level];
+    z.head = (int32_t*) hf_malloc(LZ_HASH_SIZE * sizeof(int32_t));
+    z.prev = (int32_t*) hf_malloc(LZ_WINDOW * sizeof(int32_t));
+    if (!z.head || !z.prev) {
+        hf_free(z.head);
+        hf_free(z.prev);
+        return (size_t) -1;
+    }
+    memset(z.head, 0xFF, LZ_HASH_SIZE * sizeof(int32_t)); /* -1 : chaîne vide */
+
+    size_t nt = 0;
+    size_t i = 0;
+    while (i < n) {
+        size_t dist = 0;
+        size_t len = chercher(&z, i, &dist);
+        if (len == 0) {
+            out[nt].len = 0;
+            out[nt].dist = src[i];
+            nt++;
+            i++;
+            continue;
+        }
+        /* paresseux : tant que la position suivante fait mieux, émettre un littéral */
+        while (z.niv->lazy && len < (size_t) z.niv->nice && i + 1 < n) {
+            size_t d2 = 0;
+            size_t l2 = chercher(&z, i + 1, &d2);
+            if (l2 <= len) break;
+            out[nt].len = 0;
+            out[nt].dist = src[i];
+            nt++;
+            i++;
+            len = l2;
+            dist = d2;
+        }
+        out[nt].len = (uint16_t) len;
+        out[nt].dist = (uint16_t) dist;
+        nt++;
+        i += len;
+    }
+
+    hf_free(z.head);
+    hf_free(z.prev);
+    return nt;
+}
@@ -0,0 +1,71 @@
+#ifndef LZ77_H
+#define LZ77_H
+
+/*
+ * lz77.h
+ *
+ * Recherche de correspondances LZ77 (chaînes de hachage sur une fenêtre
+ * glissante de LZ_WINDOW octets) et recopie des correspondances au décodage.
+ * Le codage entropique des séquences produites (HF_CODEC_LZ) est dans codec.c.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LZ_MIN_MATCH     3
+#define LZ_MAX_MATCH     258
+#define LZ_WINDOW        32768
+
+#define LZ_LEVEL_MIN     1
+#define LZ_LEVEL_MAX     9
+#define LZ_LEVEL_DEFAULT 6
+
+/* Séquence : len == 0 -> littéral (octet dans dist), sinon correspondance
+ * de len octets (LZ_MIN_MATCH..LZ_MAX_MATCH) à dist octets en arrière.
+ */
+typedef struct LzToken {
+    uint16_t len;
+    uint16_t dist;
+} LzToken;
+
+/* Découpe src[0..n) en séquences (out : au moins n entrées).
+ * level (LZ_LEVEL_MIN..LZ_LEVEL_MAX) règle la longueur des chaînes parcourues
+ * et la recherche paresseuse (niveaux 4 et plus).
+ * Retourne le nombre de séquences, ou (size_t) -1 si l'allocation échoue.
+ */
+size_t lz_parse(const unsigned char *src, size_t n, int level, LzToken *out);
+
+/* Recopie len octets situés dist octets avant d (dist >= 1, déjà décodés).
+ * Par mots de 8 octets (stores chevauchants) quand il reste au moins 8 octets
+ * de marge avant fin ; une distance courte est d'abord élargie en doublant le
+ * motif jusqu'à 8 octets. Octet par octet en fin de tampon.
+ */
+static inline void lz_copier(unsigned char *d, size_t dist, size_t len, const unsigned char *fin) {
+    const unsigned char *s = d - dist;
+    if (dist == 1) {
+        memset(d, *s, len);
+        return;
+    }
+    if ((size_t) (fin - d) >= len + 8) {
+        /* [s, d) est périodique de période dist : d - s double à chaque copie */
+        while (dist < 8 && len > 0) {
+            size_t c = (dist < len) ? dist : len;
+            memcpy(d, s, c);
+            d += c;
+            len -= c;
+            dist += c;
+        }
+        if (len == 0) return;
+        unsigned char *e = d + len;
+        do {
+            memcpy(d, s, 8);
+            d += 8;
+            s += 8;
+        } while (d < e);
+        return;
+    }
+    while (len--) *d++ = *s++;
+}
+
+#endif /* LZ77_H */
@@ -6,9 +6,41 @@
  * Usage :
  *   ./huffman -c input_path output_path   # compresse
  *   ./huffman -d input_path output_path   # décompresse
+ *   ./huffman -a new_data archive.huff    # ajoute new_data à la fin de l'archive
+ *   ./huffman -t archive.huff             # vérifie l'archive (sommes de contrôle)
+ *   ./huffman -i a.huff [b.huff ...]      # statistiques lues dans l'en-tête / l'index
+ *   ./huffman -c - -  < in > out.huff     # "-" : stdin / stdout (flux)
  *   ./huffman -h                          # aide
  *
- * Le programme appelle compress_file() / decompress_file() définies dans io.c.
+ *   ./huffman --batch -c f1 f2 ...        # compresse chaque fichier en fN.huff
+ *   ./huffman --batch -d f1.huff ... | -  # décompresse (liste, ou manifeste sur stdin)
+ *
+ * Options :
+ *   -1 .. -9      niveau de compression : codec, effort et taille de bloc, du
+ *                 plus rapide au meilleur taux (défaut : -2, voir archive.h) ;
+ *                 les options --codec / --level / --split ci-dessous le précisent
+ *   --store DIR   découpage FastCDC + déduplication dans le magasin de chunks DIR
+ *                 (à repasser à -d / -a pour une archive créée avec --store)
+ *   --checksum none|crc32c|xxh64
+ *                 somme de contrôle par bloc des nouvelles archives (défaut : crc32c)
+ *   --codec huff|pairs|lz|bwt
+ *                 codage des blocs : octets (défaut), octets + paires fréquentes,
+ *                 LZ77 + Huffman (deflate), ou BWT + MTF + Huffman (blocs de 1 Mio)
+ *   --level N     effort de la recherche LZ77, 1 (rapide) .. 9 (meilleur taux)
+ *   --split auto|fixed
+ *                 frontières de blocs choisies selon l'entropie (défaut, codecs
+ *                 huff et pairs) ou blocs fixes de 128 Kio
+ *   --trace FILE  écrit dans FILE une trace Chrome trace-event (phases du codec,
+ *                 blocs, threads ; chrome://tracing ou ui.perfetto.dev)
+ *   --mem-stats   compte les allocations du codec et affiche sur stderr leur
+ *                 nombre, les octets demandés et le pic de mémoire du fichier
+ *                 traité (--batch : champs allocs, bytes, peak de chaque ligne
+ *                 JSON, puis le total du processus)
+ *   -j N          nombre de threads (défaut : nombre de processeurs)
+ *   --batch       traite une liste de fichiers ; une ligne JSON par fichier sur stdout
+ *
+ * Le programme appelle compress_file() / decompress_file() définies dans io.c
+ * et archive_append() définie dans archive.c.
  */
 
 #include <stdio.h>
@@ -18,7 +50,16 @@
 #include <sys/stat.h>
 
 #include "io.h"        /* compress_file, decompress_file, etc. */
+#include "archive.h"   /* archive_append, archive_*_pool */
+#include "batch.h"     /* mode --batch */
+#include "inspect.h"   /* mode -i */
+#include "pool.h"
 #include "huffman.h"   /* pour fonctions utilitaires si besoin (affichage arbre...) */
+#include "bitkernels.h" /* choix des noyaux bit-à-bit au démarrage */
+#include "codec.h"     /* HF_CODEC_* (--codec) */
+#include "lz77.h"      /* LZ_LEVEL_* (--level) */
+#include "alloc.h"     /* allocateur de comptage (--mem-stats) */
+#include "trace.h"     /* --trace */
 
 /* Retourne la taille (en octets) d'un fichier. -1 en cas d'erreur. */
 static long long file_size_bytes(const char *path) {
@@ -32,7 +73,23 @@ static void print_usage(const char *prog) {
     printf("Usage:\n");
     printf("  %s -c <input> <output>    # compresser\n", prog);
     printf("  %s -d <input> <output>    # décompresser\n", prog);
+    printf("  %s -a <input> <archive>   # ajouter input à la fin de l'archive\n", prog);
+    printf("  %s -t <archive>           # vérifier l'intégrité de l'archive\n", prog);
+    printf("  %s -i <archive>...        # statistiques sans décoder (en-tête, index, tables)\n", prog);
+    printf("  %s -c|-d - -              # \"-\" : entrée / sortie standard (flux)\n", prog);
     printf("  %s -h                     # aide\n", prog);
+    printf("Options:\n");
+    printf("  -1 .. -9        niveau : 1-2 Huffman, 3-7 LZ77, 8-9 BWT (défaut : -%d)\n", HF_LEVEL_DEFAULT);
+    printf("  --store <dir>   dédupliquer les chunks dans le magasin <dir>\n");
+    printf("  --checksum <c>  none | crc32c (défaut) | xxh64\n");
+    printf("  --codec <c>     huff (défaut) | pairs (octets + paires d'octets) | lz (LZ77 + Huffman)\n");
+    printf("                  | bwt (Burrows-Wheeler, meilleur taux, blocs de 1 Mio)\n");
+    printf("  --level <n>     effort LZ77 pour --codec lz, 1 (rapide) .. 9 (défaut : %d)\n", LZ_LEVEL_DEFAULT);
+    printf("  --split <s>     auto (défaut : blocs selon l'entropie, huff/pairs) | fixed\n");
+    printf("  --trace <f>     trace Chrome/Perfetto des phases, blocs et threads dans <f>\n");
+    printf("  --mem-stats     allocations, octets et pic mémoire du codec (sur stderr)\n");
+    printf("  -j <n>          nombre de threads (défaut : processeurs en ligne)\n");
+    printf("  --batch         -c/-d sur une liste de fichiers (\"-\" = manifeste sur stdin)\n");
 }
 
 /* Optionnel : affiche résumé après compression */
@@ -53,29 +110,61 @@ static void print_stats_after_compress(const char *in, const char *out) {
     }
 }
 
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        print_usage(argv[0]);
-        return EXIT_FAILURE;
+/* --mem-stats : bilan de l'allocateur de comptage pour un fichier ou pour
+ * tout le processus (stderr : stdout peut porter les lignes JSON de --batch) */
+static void print_mem_stats(const char *quoi, const HfAllocStats *st) {
+    fprintf(stderr, "Mémoire (%s) : %llu allocations, %llu réallocations, %llu octets demandés, pic %llu octets\n",
+            quoi, (unsigned long long) st->allocations, (unsigned long long) st->reallocations,
+            (unsigned long long) st->bytes, (unsigned long long) st->peak);
+    if (st->current > 0) {
+        fprintf(stderr, "Mémoire (%s) : %llu octets non libérés\n", quoi, (unsigned long long) st->current);
     }
+}
 
-    if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
-        print_usage(argv[0]);
-        return EXIT_SUCCESS;
-    }
+/* "-1" .. "-9" : niveau de compression */
+static int niveau_option(const char *a) {
+    return (a[0] == '-' && a[1] >= '0' + HF_LEVEL_MIN && a[1] <= '0' + HF_LEVEL_MAX && a[2] == '\0')
+               ? a[1] - '0' : 0;
+}
 
-    if (argc != 4) {
-        print_usage(argv[0]);
+static int est_flux(const char *path) {
+    return strcmp(path, "-") == 0;
+}
+
+/* -c / -d avec "-" pour stdin et/ou stdout : codage séquentiel au fil du flux,
+ * sans fichier intermédiaire (archives HUF2 ou HUF1).
+ * Seules les erreurs sont affichées, sur stderr : stdout ne porte que les données.
+ */
+static int run_stream(const char *mode, const char *input, const char *output, const HfOptions *opt) {
+    const int compresser = (mode[1] == 'c');
+    FILE *in = est_flux(input) ? stdin : fopen(input, "rb");
+    FILE *out = est_flux(output) ? stdout : fopen(output, "wb");
+    int rc = -1;
+    if (in && out) {
+        rc = compresser ? archive_compress_stream(in, out, opt) : archive_decompress_stream(in, out, opt);
+    }
+    if (in && in != stdin) fclose(in);
+    if (out == stdout) {
+        if (fflush(stdout) != 0) rc = -1;
+    } else if (out && fclose(out) != 0) {
+        rc = -1;
+    }
+    if (rc != 0) {
+        fprintf(stderr, "Erreur : échec de la %s (code %d)\n", compresser ? "compression" : "décompression", rc);
         return EXIT_FAILURE;
     }
+    return EXIT_SUCCESS;
+}
 
-    const char *mode = argv[1];
-    const char *input = argv[2];
-    const char *output = argv[3];
-
+/* -c / -d / -a sur un seul fichier */
+static int run_single(const char *mode, const char *input, const char *output,
+                      const HfOptions *opt, Pool *pool) {
+    if (mode[1] != 'a' && (est_flux(input) || est_flux(output))) {
+        return run_stream(mode, input, output, opt);
+    }
     if (strcmp(mode, "-c") == 0) {
         printf("Compression : %s -> %s\n", input, output);
-        int rc = compress_file(input, output);
+        int rc = archive_compress_pool(input, output, opt, pool);
         if (rc != 0) {
             fprintf(stderr, "Erreur : échec de la compression (code %d)\n", rc);
             return EXIT_FAILURE;
@@ -84,7 +173,7 @@ int main(int argc, char *argv[]) {
         return EXIT_SUCCESS;
     } else if (strcmp(mode, "-d") == 0) {
         printf("Décompression : %s -> %s\n", input, output);
-        int rc = decompress_file(input, output);
+        int rc = archive_decompress_pool(input, output, opt, pool);
         if (rc != 0) {
             fprintf(stderr, "Erreur : échec de la décompression (code %d)\n", rc);
             return EXIT_FAILURE;
@@ -97,8 +186,237 @@ int main(int argc, char *argv[]) {
         }
         return EXIT_SUCCESS;
     } else {
-        fprintf(stderr, "Mode inconnu : %s\n", mode);
+        long long before = file_size_bytes(output);
+        printf("Ajout : %s -> %s\n", input, output);
+        int rc = archive_append(input, output, opt);
+        if (rc != 0) {
+            fprintf(stderr, "Erreur : échec de l'ajout (code %d)\n", rc);
+            return EXIT_FAILURE;
+        }
+        long long after = file_size_bytes(output);
+        if (before >= 0 && after >= 0) {
+            printf("Archive : %s  => %lld octets (+%lld)\n", output, after, after - before);
+        }
+        return EXIT_SUCCESS;
+    }
+}
+
+/* -t : décode l'archive en mémoire et vérifie chaque bloc */
+static int run_test(const char *archive, const HfOptions *opt, Pool *pool) {
+    uint32_t bad = 0;
+    int rc = archive_test(archive, opt, pool, &bad);
+    if (rc != 0) {
+        if (bad > 0) {
+            fprintf(stderr, "Erreur : %s : %u bloc(s) corrompu(s)\n", archive, bad);
+        } else {
+            fprintf(stderr, "Erreur : %s : archive illisible ou corrompue\n", archive);
+        }
+        return EXIT_FAILURE;
+    }
+    printf("%s : OK\n", archive);
+    return EXIT_SUCCESS;
+}
+
+/* -i : rapport de chaque archive, sans décoder les données */
+static int run_inspect(char **files, int nfiles) {
+    int echecs = 0;
+    for (int i = 0; i < nfiles; ++i) {
+        if (inspect_archive(files[i], stdout) != 0) {
+            fprintf(stderr, "Erreur : %s : archive illisible ou format inconnu\n", files[i]);
+            echecs++;
+        }
+    }
+    return (echecs == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Mode --batch : fichiers en arguments ou manifeste sur stdin ("-"). */
+static int run_batch(char mode, char **files, int nfiles, const HfOptions *opt, Pool *pool) {
+    char **inputs = files, **outputs = NULL;
+    int n = nfiles;
+    if (nfiles == 1 && strcmp(files[0], "-") == 0) {
+        n = batch_read_manifest(stdin, &inputs, &outputs);
+        if (n < 0) {
+            fprintf(stderr, "Erreur : lecture du manifeste impossible\n");
+            return EXIT_FAILURE;
+        }
+    }
+    int echecs = batch_run(mode, inputs, outputs, n, opt, pool);
+    if (outputs) {
+        for (int i = 0; i < n; ++i) {
+            free(inputs[i]);
+            free(outputs[i]);
+        }
+        free(inputs);
+        free(outputs);
+    }
+    return (echecs == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    HfOptions opt;
+    hf_options_defaut(&opt);
+    const char *mode = NULL;
+    int batch = 0;
+    int mem_stats = 0;
+    const char *trace_path = NULL;
+    int threads = pool_default_size();
+    char **args = (char**) malloc(sizeof(char*) * (size_t) argc);
+    int nargs = 0;
+    if (!args) return EXIT_FAILURE;
+
+    /* le niveau s'applique d'abord : les options explicites le précisent,
+     * quel que soit leur ordre sur la ligne de commande */
+    for (int i = 1; i < argc; ++i) {
+        if (niveau_option(argv[i])) hf_options_level(&opt, niveau_option(argv[i]));
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (niveau_option(a)) {
+            continue;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            print_usage(argv[0]);
+            free(args);
+            return EXIT_SUCCESS;
+        } else if (strcmp(a, "-c") == 0 || strcmp(a, "-d") == 0 || strcmp(a, "-a") == 0 ||
+                   strcmp(a, "-t") == 0 || strcmp(a, "-i") == 0) {
+            if (mode) {
+                print_usage(argv[0]);
+                free(args);
+                return EXIT_FAILURE;
+            }
+            mode = a;
+        } else if (strcmp(a, "--batch") == 0) {
+            batch = 1;
+        } else if (strcmp(a, "--mem-stats") == 0) {
+            mem_stats = 1;
+        } else if (strcmp(a, "--store") == 0 || strcmp(a, "-j") == 0 || strcmp(a, "--checksum") == 0 ||
+                   strcmp(a, "--codec") == 0 || strcmp(a, "--level") == 0 ||
+                   strcmp(a, "--split") == 0 || strcmp(a, "--trace") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Option %s : argument manquant\n", a);
+                free(args);
+                return EXIT_FAILURE;
+            }
+            if (a[1] == 'j') {
+                threads = atoi(argv[++i]);
+                if (threads < 1) threads = 1;
+            } else if (strcmp(a, "--checksum") == 0) {
+                const char *c = argv[++i];
+                if (strcmp(c, "none") == 0) opt.checksum = HF_CHECKSUM_NONE;
+                else if (strcmp(c, "crc32c") == 0) opt.checksum = HF_CHECKSUM_CRC32C;
+                else if (strcmp(c, "xxh64") == 0) opt.checksum = HF_CHECKSUM_XXH64;
+                else {
+                    fprintf(stderr, "Somme de contrôle inconnue : %s\n", c);
+                    free(args);
+                    return EXIT_FAILURE;
+                }
+            } else if (strcmp(a, "--codec") == 0) {
+                const char *c = argv[++i];
+                int codec;
+                if (strcmp(c, "huff") == 0) codec = HF_CODEC_HUFF;
+                else if (strcmp(c, "pairs") == 0) codec = HF_CODEC_PAIRS;
+                else if (strcmp(c, "lz") == 0) codec = HF_CODEC_LZ;
+                else if (strcmp(c, "bwt") == 0) codec = HF_CODEC_BWT;
+                else {
+                    fprintf(stderr, "Codec inconnu : %s\n", c);
+                    free(args);
+                    return EXIT_FAILURE;
+                }
+                /* taille de bloc du codec seulement s'il change : -9 --codec bwt
+                 * garde les blocs de 4 Mio du niveau */
+                if (codec != opt.codec) {
+                    opt.codec = codec;
+                    opt.block_size = (codec == HF_CODEC_BWT) ? HF_BWT_BLOCK_SIZE : HF2_DEFAULT_BLOCK_SIZE;
+                }
+            } else if (strcmp(a, "--level") == 0) {
+                opt.level = atoi(argv[++i]);
+                if (opt.level < LZ_LEVEL_MIN || opt.level > LZ_LEVEL_MAX) {
+                    fprintf(stderr, "Niveau invalide : %s (%d..%d)\n", argv[i], LZ_LEVEL_MIN, LZ_LEVEL_MAX);
+                    free(args);
+                    return EXIT_FAILURE;
+                }
+            } else if (strcmp(a, "--trace") == 0) {
+                trace_path = argv[++i];
+            } else if (strcmp(a, "--split") == 0) {
+                const char *c = argv[++i];
+                if (strcmp(c, "auto") == 0) opt.split = 1;
+                else if (strcmp(c, "fixed") == 0) opt.split = 0;
+                else {
+                    fprintf(stderr, "Découpage inconnu : %s\n", c);
+                    free(args);
+                    return EXIT_FAILURE;
+                }
+            } else {
+                opt.store_dir = argv[++i];
+            }
+        } else if (a[0] == '-' && a[1] != '\0') {
+            fprintf(stderr, "Mode inconnu : %s\n", a);
+            print_usage(argv[0]);
+            free(args);
+            return EXIT_FAILURE;
+        } else {
+            args[nargs++] = argv[i];
+        }
+    }
+
+    int attendus = (mode && mode[1] == 't') ? 1 : 2;
+    if (!mode || (batch ? (nargs < 1 || mode[1] == 'a' || mode[1] == 't' || mode[1] == 'i')
+                        : mode[1] == 'i' ? nargs < 1 : nargs != attendus)) {
         print_usage(argv[0]);
+        free(args);
         return EXIT_FAILURE;
     }
+
+    /* sélection unique de la variante des noyaux (cpuid) */
+    bit_kernels_init();
+    if (mem_stats) hf_set_allocator(hf_counting_allocator());
+    if (trace_path) {
+        if (trace_start(trace_path) != 0) {
+            fprintf(stderr, "Erreur : impossible de créer la trace %s\n", trace_path);
+            free(args);
+            return EXIT_FAILURE;
+        }
+        trace_nommer_thread("principal");
+    }
+
+    TRACE_DEBUT(t_total);
+    Pool *pool = (threads > 1 && mode[1] != 'i') ? pool_create(threads) : NULL;
+    /* --mem-stats : une portée par fichier (celles de --batch sont dans batch.c) */
+    const int par_fichier = mem_stats && !batch && mode[1] != 'i';
+    HfAllocScope portee;
+    HfAllocStats mem;
+    if (par_fichier) hf_alloc_scope_begin(&portee);
+    int status;
+    if (batch) {
+        status = run_batch(mode[1], args, nargs, &opt, pool);
+    } else if (mode[1] == 't') {
+        status = run_test(args[0], &opt, pool);
+    } else if (mode[1] == 'i') {
+        status = run_inspect(args, nargs);
+    } else {
+        status = run_single(mode, args[0], args[1], &opt, pool);
+    }
+    if (par_fichier) {
+        hf_alloc_scope_end(&portee, &mem);
+        print_mem_stats(args[0], &mem);
+    }
+    pool_destroy(pool);
+    TRACE_FIN(t_total, batch ? "batch" : mode[1] == 'c' ? "compression" : mode[1] == 'd' ? "décompression"
+                                : mode[1] == 'a' ? "ajout" : mode[1] == 'i' ? "inspection" : "test", nargs);
+    if (trace_path && trace_stop() != 0) {
+        fprintf(stderr, "Erreur : écriture de la trace %s impossible\n", trace_path);
+        status = EXIT_FAILURE;
+    }
+    if (mem_stats && !par_fichier) {
+        hf_alloc_stats(&mem);
+        print_mem_stats("total", &mem);
+    }
+    free(args);
+    return status;
 }
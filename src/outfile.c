@@ -0,0 +1,76 @@
+/*
+ * outfile.c
+ *
+ * Fichier de sortie préalloué (voir outfile.h).
+ */
+
+#define _GNU_SOURCE          /* fallocate */
+#define _FILE_OFFSET_BITS 64
+
+#include "outfile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Donne au fichier sa taille finale en réservant ses blocs ; un système de
+ * fichiers qui ne sait pas les réserver reçoit un fichier creux (ftruncate).
+ * Retourne 0 si OK, -1 si erreur (ENOSPC...).
+ */
+static int reserver_place(int fd, uint64_t size) {
+#ifdef __linux__
+    if (fallocate(fd, 0, 0, (off_t) size) == 0) return 0;
+    if (errno != EOPNOTSUPP && errno != ENOSYS) return -1;
+#else
+    int e = posix_fallocate(fd, 0, (off_t) size);
+    if (e == 0) return 0;
+    if (e != EINVAL && e != EOPNOTSUPP) return -1;
+#endif
+    return (ftruncate(fd, (off_t) size) == 0) ? 0 : -1;
+}
+
+int output_open(HfOutput *o, const char *path, uint64_t size) {
+    if (!o || !path) return -1;
+    o->size = size;
+    o->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (o->fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(o->fd, &st) != 0 || (S_ISREG(st.st_mode) && size > 0 && reserver_place(o->fd, size) != 0)) {
+        close(o->fd);
+        o->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int output_write(const HfOutput *o, uint64_t off, const void *buf, size_t len) {
+    if (!o || o->fd < 0 || off > o->size || len > o->size - off) return -1;
+    const unsigned char *p = (const unsigned char*) buf;
+    while (len > 0) {
+        ssize_t w = pwrite(o->fd, p, len, (off_t) off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        off += (uint64_t) w;
+        len -= (size_t) w;
+    }
+    return 0;
+}
+
+int output_close(HfOutput *o) {
+    if (!o || o->fd < 0) return -1;
+    int rc = (close(o->fd) == 0) ? 0 : -1;
+    o->fd = -1;
+    return rc;
+}
+
+void output_abort(HfOutput *o) {
+    if (!o || o->fd < 0) return;
+    struct stat st;
+    if (fstat(o->fd, &st) == 0 && S_ISREG(st.st_mode) && ftruncate(o->fd, 0) != 0) {
+        /* rien de mieux à faire : le fichier garde sa taille */
+    }
+    close(o->fd);
+    o->fd = -1;
+}
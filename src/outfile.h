@@ -0,0 +1,46 @@
+#ifndef OUTFILE_H
+#define OUTFILE_H
+
+/*
+ * outfile.h
+ *
+ * Fichier de sortie de taille connue d'avance (décompression) :
+ * - la place est réservée d'un coup (fallocate) : pas d'allocation de blocs
+ *   disque pendant le décodage, et un disque plein est détecté avant de
+ *   commencer ;
+ * - les décodeurs écrivent dans leurs propres tampons, vidés par gros
+ *   morceaux (un bloc entier au moins) avec des écritures positionnées :
+ *   plusieurs threads écrivent en même temps des plages disjointes.
+ *
+ * Pas de projection mmap : sur un fichier neuf, chaque page projetée coûte
+ * une faute et une mise à zéro, plus cher que la copie de pwrite.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HfOutput {
+    int fd;
+    uint64_t size;         /* taille finale du fichier */
+} HfOutput;
+
+/* Crée (ou tronque) path et lui donne sa taille finale size (préallouée si
+ * c'est un fichier régulier ; /dev/null et les périphériques sont acceptés).
+ * Retourne 0 si OK, -1 si erreur (ouverture, place insuffisante...).
+ */
+int output_open(HfOutput *o, const char *path, uint64_t size);
+
+/* Écrit len octets à la position off (off + len <= size).
+ * Retourne 0 si OK, -1 si erreur.
+ */
+int output_write(const HfOutput *o, uint64_t off, const void *buf, size_t len);
+
+/* Ferme le fichier. Retourne 0 si OK, -1 si erreur. */
+int output_close(HfOutput *o);
+
+/* Ferme le fichier après un échec de décodage : il est vidé, ce qui rend la
+ * place réservée au lieu de laisser un fichier de la taille finale.
+ */
+void output_abort(HfOutput *o);
+
+#endif /* OUTFILE_H */
@@ -0,0 +1,252 @@
+/*
+ * pool.c
+ *
+ * Pool de threads à vol de tâches (voir pool.h).
+ *
+ * Les files sont des tableaux circulaires protégés chacun par son mutex :
+ * les tâches du projet (un fichier, un segment de blocs) durent au moins des
+ * centaines de microsecondes, un verrou par opération est négligeable.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+#include "alloc.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct Task {
+    void (*fn)(void *);
+    void *arg;
+    PoolGroup *group;
+    HfAllocScope *portee;   /* portée d'allocation de celui qui l'a soumise */
+} Task;
+
+typedef struct Deque {
+    pthread_mutex_t mtx;
+    Task *tab;
+    int cap;
+    int head;     /* plus ancienne tâche (côté vol) */
+    int count;
+} Deque;
+
+struct Pool {
+    int n;
+    Deque *deques;            /* une par travailleur ; 0 = thread créateur */
+    pthread_t *threads;
+    atomic_int queued;        /* tâches en file, tous travailleurs confondus */
+    atomic_int stop;
+    pthread_mutex_t sleep_mtx;
+    pthread_cond_t sleep_cond;
+};
+
+/* indice du travailleur courant dans le pool courant (-1 hors pool) */
+static _Thread_local const Pool *tls_pool = NULL;
+static _Thread_local int tls_id = -1;
+
+static int deque_push(Deque *d, Task t) {
+    pthread_mutex_lock(&d->mtx);
+    if (d->count == d->cap) {
+        int nc = (d->cap == 0) ? 64 : d->cap * 2;
+        Task *tmp = (Task*) malloc(sizeof(Task) * (size_t) nc);
+        if (!tmp) {
+            pthread_mutex_unlock(&d->mtx);
+            return -1;
+        }
+        for (int i = 0; i < d->count; ++i) tmp[i] = d->tab[(d->head + i) % d->cap];
+        free(d->tab);
+        d->tab = tmp;
+        d->cap = nc;
+        d->head = 0;
+    }
+    d->tab[(d->head + d->count) % d->cap] = t;
+    d->count++;
+    pthread_mutex_unlock(&d->mtx);
+    return 0;
+}
+
+/* lifo = 1 : côté propriétaire (dernière tâche déposée) ; 0 : côté voleur */
+static int deque_pop(Deque *d, int lifo, Task *out) {
+    pthread_mutex_lock(&d->mtx);
+    if (d->count == 0) {
+        pthread_mutex_unlock(&d->mtx);
+        return 0;
+    }
+    if (lifo) {
+        *out = d->tab[(d->head + d->count - 1) % d->cap];
+    } else {
+        *out = d->tab[d->head];
+        d->head = (d->head + 1) % d->cap;
+    }
+    d->count--;
+    pthread_mutex_unlock(&d->mtx);
+    return 1;
+}
+
+static int self_id(const Pool *pool) {
+    return (tls_pool == pool && tls_id >= 0) ? tls_id : 0;
+}
+
+/* Prend une tâche : d'abord la sienne (LIFO), sinon en vole une (FIFO). */
+static int trouver_tache(Pool *pool, int id, Task *t) {
+    if (deque_pop(&pool->deques[id], 1, t)) return 1;
+    for (int k = 1; k < pool->n; ++k) {
+        if (deque_pop(&pool->deques[(id + k) % pool->n], 0, t)) return 1;
+    }
+    return 0;
+}
+
+static void executer(Pool *pool, Task *t) {
+    atomic_fetch_sub(&pool->queued, 1);
+    TRACE_DEBUT(t_tache);
+    HfAllocScope *avant = hf_alloc_scope_swap(t->portee);
+    t->fn(t->arg);
+    hf_alloc_scope_swap(avant);
+    TRACE_FIN(t_tache, "tâche", 0);
+    if (atomic_fetch_sub(&t->group->pending, 1) == 1) {
+        /* groupe terminé : réveiller un éventuel pool_wait() endormi */
+        pthread_mutex_lock(&pool->sleep_mtx);
+        pthread_cond_broadcast(&pool->sleep_cond);
+        pthread_mutex_unlock(&pool->sleep_mtx);
+    }
+}
+
+typedef struct WorkerArg {
+    Pool *pool;
+    int id;
+} WorkerArg;
+
+static void* worker_main(void *p) {
+    WorkerArg *wa = (WorkerArg*) p;
+    Pool *pool = wa->pool;
+    int id = wa->id;
+    free(wa);
+    tls_pool = pool;
+    tls_id = id;
+    char nom[32];
+    snprintf(nom, sizeof(nom), "travailleur %d", id);
+    trace_nommer_thread(nom);
+    TRACE_DEBUT(t_vie);
+
+    for (;;) {
+        Task t;
+        if (trouver_tache(pool, id, &t)) {
+            executer(pool, &t);
+            continue;
+        }
+        pthread_mutex_lock(&pool->sleep_mtx);
+        while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stop)) {
+            pthread_cond_wait(&pool->sleep_cond, &pool->sleep_mtx);
+        }
+        pthread_mutex_unlock(&pool->sleep_mtx);
+        if (atomic_load(&pool->stop) && atomic_load(&pool->queued) == 0) break;
+    }
+    TRACE_FIN(t_vie, "travailleur", id);
+    return NULL;
+}
+
+int pool_default_size(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n < 1) ? 1 : (int) n;
+}
+
+Pool* pool_create(int n) {
+    if (n < 1) n = 1;
+    Pool *pool = (Pool*) calloc(1, sizeof(Pool));
+    if (!pool) return NULL;
+    pool->n = n;
+    pool->deques = (Deque*) calloc((size_t) n, sizeof(Deque));
+    pool->threads = (pthread_t*) calloc((size_t) n, sizeof(pthread_t));
+    if (!pool->deques || !pool->threads) {
+        free(pool->deques);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    for (int i = 0; i < n; ++i) pthread_mutex_init(&pool->deques[i].mtx, NULL);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->stop, 0);
+    pthread_mutex_init(&pool->sleep_mtx, NULL);
+    pthread_cond_init(&pool->sleep_cond, NULL);
+
+    tls_pool = pool;
+    tls_id = 0;
+    for (int i = 1; i < n; ++i) {
+        WorkerArg *wa = (WorkerArg*) malloc(sizeof(WorkerArg));
+        if (wa) {
+            wa->pool = pool;
+            wa->id = i;
+        }
+        if (!wa || pthread_create(&pool->threads[i], NULL, worker_main, wa) != 0) {
+            free(wa);
+            /* moins de threads que demandé : le pool reste utilisable */
+            pool->n = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+int pool_size(const Pool *pool) {
+    return pool ? pool->n : 1;
+}
+
+int pool_submit(Pool *pool, PoolGroup *g, void (*fn)(void *), void *arg) {
+    if (!pool || !g || !fn) return -1;
+    Task t = { fn, arg, g, hf_alloc_scope_current() };
+    atomic_fetch_add(&g->pending, 1);
+    atomic_fetch_add(&pool->queued, 1);
+    if (deque_push(&pool->deques[self_id(pool)], t) != 0) {
+        atomic_fetch_sub(&pool->queued, 1);
+        atomic_fetch_sub(&g->pending, 1);
+        return -1;
+    }
+    pthread_mutex_lock(&pool->sleep_mtx);
+    pthread_cond_broadcast(&pool->sleep_cond);
+    pthread_mutex_unlock(&pool->sleep_mtx);
+    return 0;
+}
+
+void pool_wait(Pool *pool, PoolGroup *g) {
+    if (!pool || !g) return;
+    int id = self_id(pool);
+    while (atomic_load(&g->pending) > 0) {
+        Task t;
+        if (trouver_tache(pool, id, &t)) {
+            executer(pool, &t);
+            continue;
+        }
+        /* rien à voler : dormir jusqu'à une nouvelle tâche ou la fin d'un groupe */
+        pthread_mutex_lock(&pool->sleep_mtx);
+        while (atomic_load(&g->pending) > 0 && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->sleep_cond, &pool->sleep_mtx);
+        }
+        pthread_mutex_unlock(&pool->sleep_mtx);
+    }
+}
+
+void pool_destroy(Pool *pool) {
+    if (!pool) return;
+    atomic_store(&pool->stop, 1);
+    pthread_mutex_lock(&pool->sleep_mtx);
+    pthread_cond_broadcast(&pool->sleep_cond);
+    pthread_mutex_unlock(&pool->sleep_mtx);
+    for (int i = 1; i < pool->n; ++i) pthread_join(pool->threads[i], NULL);
+    for (int i = 0; i < pool->n; ++i) {
+        pthread_mutex_destroy(&pool->deques[i].mtx);
+        free(pool->deques[i].tab);
+    }
+    pthread_mutex_destroy(&pool->sleep_mtx);
+    pthread_cond_destroy(&pool->sleep_cond);
+    if (tls_pool == pool) {
+        tls_pool = NULL;
+        tls_id = -1;
+    }
+    free(pool->deques);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,53 @@
+#ifndef POOL_H
+#define POOL_H
+
+/*
+ * pool.h
+ *
+ * Pool de threads à vol de tâches (work stealing).
+ *
+ * - chaque thread possède sa file : il y dépose ses sous-tâches et les
+ *   reprend en LIFO (données encore chaudes dans son cache) ;
+ * - un thread inactif vole la tâche la plus ancienne (FIFO) d'un autre ;
+ * - pool_wait() ne bloque pas bêtement : le thread qui attend exécute des
+ *   tâches en attendant la fin de son groupe (fork/join imbriqués possibles).
+ *
+ * Le thread qui crée le pool compte pour un travailleur : pool_create(n)
+ * lance n-1 threads supplémentaires.
+ */
+
+#include <stdatomic.h>
+
+typedef struct Pool Pool;
+
+/* Groupe de tâches attendues ensemble (initialiser avec POOL_GROUP_INIT). */
+typedef struct PoolGroup {
+    atomic_int pending;
+} PoolGroup;
+
+#define POOL_GROUP_INIT { 0 }
+
+/* Nombre de processeurs en ligne (taille par défaut d'un pool). */
+int pool_default_size(void);
+
+/* Crée un pool de n travailleurs (n >= 1). Retourne NULL en cas d'échec. */
+Pool* pool_create(int n);
+
+/* Attend la fin de toutes les tâches puis détruit le pool. */
+void pool_destroy(Pool *pool);
+
+/* Nombre de travailleurs (thread appelant compris). */
+int pool_size(const Pool *pool);
+
+/* Soumet fn(arg) dans le groupe g. fn s'exécute dans la portée d'allocation
+ * (alloc.h) du thread appelant. Retourne 0 si OK, -1 si erreur d'allocation
+ * (la tâche n'est alors pas soumise).
+ */
+int pool_submit(Pool *pool, PoolGroup *g, void (*fn)(void *), void *arg);
+
+/* Attend que toutes les tâches du groupe soient terminées, en exécutant
+ * d'autres tâches du pool pendant l'attente.
+ */
+void pool_wait(Pool *pool, PoolGroup *g);
+
+#endif /* POOL_H */
@@ -0,0 +1,107 @@
+/*
+ * split.c
+ *
+ * Coût estimé d'un bloc de N octets d'histogramme H :
+ *   bits = N.log2(N) - somme H[s].log2(H[s]) + 8.header_bytes
+ * (longueur de code idéale -log2(H[s]/N) par occurrence). Fusionner deux
+ * morceaux ou déplacer une frontière ne demande que d'ajouter / retrancher
+ * l'histogramme de la partie déplacée.
+ */
+
+#include "split.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t h[256];
+    size_t n;
+} Histo;
+
+static void histo_ajouter(Histo *a, const unsigned char *p, size_t n) {
+    for (size_t i = 0; i < n; ++i) a->h[p[i]]++;
+    a->n += n;
+}
+
+static void histo_retirer(Histo *a, const unsigned char *p, size_t n) {
+    for (size_t i = 0; i < n; ++i) a->h[p[i]]--;
+    a->n -= n;
+}
+
+static double cout_bits(const Histo *a, size_t header_bytes) {
+    if (a->n == 0) return 0.0;
+    double s = (double) a->n * log2((double) a->n);
+    for (int c = 0; c < 256; ++c) {
+        if (a->h[c] > 1) s -= (double) a->h[c] * log2((double) a->h[c]);
+    }
+    return s + 8.0 * (double) header_bytes;
+}
+
+/* Frontière entre gauche = p[0..b) et droite = p[b..fin) minimisant la somme
+ * des coûts, cherchée par pas de SPLIT_STEP autour de b (déplacement d'au
+ * plus un granule de chaque côté).
+ */
+static size_t affiner(const unsigned char *p, size_t b, size_t fin, Histo *g, Histo *d,
+                      size_t header_bytes) {
+    size_t meilleure = b;
+    double meilleur = cout_bits(g, header_bytes) + cout_bits(d, header_bytes);
+
+    /* vers la gauche : les octets quittent g pour d */
+    Histo gg = *g, dd = *d;
+    for (size_t x = b; x >= 2 * SPLIT_STEP && b - x < SPLIT_GRANULE;) {
+        histo_retirer(&gg, p + x - SPLIT_STEP, SPLIT_STEP);
+        histo_ajouter(&dd, p + x - SPLIT_STEP, SPLIT_STEP);
+        x -= SPLIT_STEP;
+        double c = cout_bits(&gg, header_bytes) + cout_bits(&dd, header_bytes);
+        if (c < meilleur) {
+            meilleur = c;
+            meilleure = x;
+        }
+    }
+    /* vers la droite : les octets quittent d pour g */
+    gg = *g;
+    dd = *d;
+    for (size_t x = b; x + 2 * SPLIT_STEP <= fin;) {
+        histo_ajouter(&gg, p + x, SPLIT_STEP);
+        histo_retirer(&dd, p + x, SPLIT_STEP);
+        x += SPLIT_STEP;
+        double c = cout_bits(&gg, header_bytes) + cout_bits(&dd, header_bytes);
+        if (c < meilleur) {
+            meilleur = c;
+            meilleure = x;
+        }
+    }
+    return meilleure;
+}
+
+size_t split_next_block(const unsigned char *p, size_t n, size_t max, size_t header_bytes) {
+    size_t lim = (n < max) ? n : max;
+    if (lim <= SPLIT_GRANULE) return lim;
+
+    Histo bloc;
+    memset(&bloc, 0, sizeof(bloc));
+    histo_ajouter(&bloc, p, SPLIT_GRANULE);
+    double cout_bloc = cout_bits(&bloc, header_bytes);
+
+    size_t len = SPLIT_GRANULE;
+    while (len < lim) {
+        size_t g = (lim - len < SPLIT_GRANULE) ? lim - len : SPLIT_GRANULE;
+        Histo suivant;
+        memset(&suivant, 0, sizeof(suivant));
+        histo_ajouter(&suivant, p + len, g);
+
+        Histo fusion = bloc;
+        for (int c = 0; c < 256; ++c) fusion.h[c] += suivant.h[c];
+        fusion.n += suivant.n;
+        double cout_fusion = cout_bits(&fusion, header_bytes);
+
+        if (cout_fusion <= cout_bloc + cout_bits(&suivant, header_bytes)) {
+            bloc = fusion;
+            cout_bloc = cout_fusion;
+            len += g;
+            continue;
+        }
+        return affiner(p, len, len + g, &bloc, &suivant, header_bytes);
+    }
+    return len;
+}
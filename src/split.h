@@ -0,0 +1,27 @@
+#ifndef SPLIT_H
+#define SPLIT_H
+
+/*
+ * split.h
+ *
+ * Découpage adaptatif en blocs : les frontières sont choisies là où une
+ * nouvelle table Huffman rapporte plus que ce qu'elle coûte, d'après une
+ * estimation du coût codé (entropie d'ordre 0 + en-tête) calculée sur des
+ * histogrammes incrémentaux, sans jamais encoder pour essayer.
+ */
+
+#include <stddef.h>
+
+#define SPLIT_GRANULE  (16u * 1024u)   /* unité de décision */
+#define SPLIT_STEP     1024u           /* pas d'ajustement d'une frontière */
+
+/* Retourne la longueur du prochain bloc commençant en p (1..min(n, max)).
+ * header_bytes : coût fixe d'un bloc supplémentaire (table, en-tête, index).
+ * Les granules de SPLIT_GRANULE octets sont fusionnés tant que le coût
+ * estimé du bloc fusionné ne dépasse pas celui de deux blocs ; la frontière
+ * retenue est ensuite déplacée par pas de SPLIT_STEP octets vers le minimum
+ * de coût.
+ */
+size_t split_next_block(const unsigned char *p, size_t n, size_t max, size_t header_bytes);
+
+#endif /* SPLIT_H */
@@ -0,0 +1,127 @@
+/*
+ * store.c
+ *
+ * Magasin de chunks sur disque (voir store.h).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "store.h"
+#include "hash.h"
+#include "alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define STORE_SEED2 0x9E3779B97F4A7C15ULL
+
+void chunk_key(const unsigned char *data, size_t n, ChunkKey *key) {
+    uint64_t a = xxh64(data, n, 0);
+    uint64_t b = xxh64(data, n, STORE_SEED2);
+    for (int i = 0; i < 8; ++i) {
+        key->b[i] = (unsigned char) (a >> (56 - 8 * i));
+        key->b[8 + i] = (unsigned char) (b >> (56 - 8 * i));
+    }
+}
+
+static int creer_dossier(const char *path) {
+    if (mkdir(path, 0755) == 0 || errno == EEXIST) return 0;
+    return -1;
+}
+
+/* Construit DIR/hh/<hex>.blk (et DIR/hh dans dirbuf si non NULL). Retourne path alloué. */
+static char* chemin_chunk(const char *dir, const ChunkKey *key, char **dirbuf) {
+    char hex[2 * CHUNK_KEY_SIZE + 1];
+    for (int i = 0; i < CHUNK_KEY_SIZE; ++i) sprintf(hex + 2 * i, "%02x", key->b[i]);
+
+    size_t n = strlen(dir) + 4 + sizeof(hex) + 8;
+    char *path = (char*) hf_malloc(n);
+    if (!path) return NULL;
+    snprintf(path, n, "%s/%.2s/%s.blk", dir, hex, hex);
+    if (dirbuf) {
+        *dirbuf = (char*) hf_malloc(n);
+        if (!*dirbuf) {
+            hf_free(path);
+            return NULL;
+        }
+        snprintf(*dirbuf, n, "%s/%.2s", dir, hex);
+    }
+    return path;
+}
+
+int store_open(const char *dir) {
+    if (!dir || !*dir) return -1;
+    return creer_dossier(dir);
+}
+
+int store_has(const char *dir, const ChunkKey *key) {
+    char *path = chemin_chunk(dir, key, NULL);
+    if (!path) return 0;
+    struct stat st;
+    int present = (stat(path, &st) == 0 && S_ISREG(st.st_mode));
+    hf_free(path);
+    return present;
+}
+
+int store_put(const char *dir, const ChunkKey *key, const unsigned char *block, size_t len) {
+    static unsigned long compteur = 0;
+    char *sub = NULL;
+    char *path = chemin_chunk(dir, key, &sub);
+    if (!path) return -1;
+
+    int rc = creer_dossier(sub);
+    size_t tn = strlen(path) + 64;
+    char *tmp = (char*) hf_malloc(tn);
+    if (!tmp) rc = -1;
+
+    if (rc == 0) {
+        unsigned long id = __atomic_fetch_add(&compteur, 1, __ATOMIC_RELAXED);
+        snprintf(tmp, tn, "%s.tmp.%ld.%lu", path, (long) getpid(), id);
+        FILE *f = fopen(tmp, "wb");
+        if (!f) {
+            rc = -1;
+        } else {
+            if (fwrite(block, 1, len, f) != len) rc = -1;
+            if (fclose(f) != 0) rc = -1;
+            /* rename atomique : un lecteur voit le chunk complet ou rien */
+            if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+            if (rc != 0) remove(tmp);
+        }
+    }
+
+    hf_free(tmp);
+    hf_free(sub);
+    hf_free(path);
+    return rc;
+}
+
+int store_get(const char *dir, const ChunkKey *key, unsigned char **buf, size_t *cap, size_t *len) {
+    char *path = chemin_chunk(dir, key, NULL);
+    if (!path) return -1;
+    FILE *f = fopen(path, "rb");
+    hf_free(path);
+    if (!f) return -1;
+
+    int rc = -1;
+    struct stat st;
+    if (fstat(fileno(f), &st) == 0 && st.st_size >= 0) {
+        size_t n = (size_t) st.st_size;
+        if (n + 8 > *cap) {
+            unsigned char *tmp = (unsigned char*) hf_realloc(*buf, n + 8);
+            if (tmp) {
+                *buf = tmp;
+                *cap = n + 8;
+            }
+        }
+        if (n + 8 <= *cap && fread(*buf, 1, n, f) == n) {
+            *len = n;
+            rc = 0;
+        }
+    }
+    fclose(f);
+    return rc;
+}
@@ -0,0 +1,42 @@
+#ifndef STORE_H
+#define STORE_H
+
+/*
+ * store.h
+ *
+ * Magasin local de chunks pour la déduplication (option --store DIR).
+ *
+ * Chaque chunk encodé est un fichier DIR/hh/<clé en hexadécimal>.blk contenant
+ * un bloc HUF2 complet (en-tête de bloc + charge utile). La clé est un
+ * hachage de 128 bits du contenu brut (deux xxh64 de graines différentes).
+ * Les écritures passent par un fichier temporaire + rename : plusieurs
+ * processus ou threads peuvent partager le même magasin.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHUNK_KEY_SIZE 16
+
+typedef struct ChunkKey {
+    unsigned char b[CHUNK_KEY_SIZE];
+} ChunkKey;
+
+/* Calcule la clé d'un chunk brut. */
+void chunk_key(const unsigned char *data, size_t n, ChunkKey *key);
+
+/* Crée le répertoire du magasin si nécessaire. Retourne 0 si OK, -1 si erreur. */
+int store_open(const char *dir);
+
+/* Retourne 1 si le chunk est présent dans le magasin, 0 sinon. */
+int store_has(const char *dir, const ChunkKey *key);
+
+/* Enregistre un bloc encodé (len octets) sous la clé donnée. Retourne 0 si OK. */
+int store_put(const char *dir, const ChunkKey *key, const unsigned char *block, size_t len);
+
+/* Lit le bloc encodé d'un chunk dans *buf (réalloué si besoin, capacité *cap,
+ * avec 8 octets de marge). Retourne 0 si OK (taille dans *len), -1 si absent.
+ */
+int store_get(const char *dir, const ChunkKey *key, unsigned char **buf, size_t *cap, size_t *len);
+
+#endif /* STORE_H */
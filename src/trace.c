@@ -0,0 +1,145 @@
+/*
+ * trace.c
+ *
+ * - un anneau de TRACE_CAPACITE intervalles par thread, créé à la demande et
+ *   inscrit dans une liste globale (seule opération sous verrou) ; quand il
+ *   est plein, les intervalles les plus anciens sont écrasés ;
+ * - trace_stop() parcourt la liste : métadonnées "thread_name", puis les
+ *   intervalles en microsecondes depuis trace_start().
+ *
+ * Les anneaux sont alloués par la libc et non par hf_malloc : la trace ne
+ * fausse pas les statistiques de --mem-stats.
+ */
+
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime */
+
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_CAPACITE (1u << 16)   /* intervalles par thread (puissance de 2) */
+
+typedef struct {
+    const char *nom;
+    uint64_t debut;
+    uint64_t duree;
+    uint64_t arg;
+} Intervalle;
+
+typedef struct Anneau {
+    Intervalle ev[TRACE_CAPACITE];
+    uint64_t total;           /* intervalles écrits (écrasés compris) */
+    int tid;
+    char nom[32];
+    struct Anneau *suivant;
+} Anneau;
+
+int trace_actif = 0;
+
+static char *chemin = NULL;
+static uint64_t origine = 0;
+static Anneau *anneaux = NULL;
+static int nb_anneaux = 0;
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static unsigned generation = 1;   /* change à chaque trace_stop : invalide les anneaux locaux */
+static _Thread_local Anneau *local = NULL;
+static _Thread_local unsigned generation_locale = 0;
+
+uint64_t trace_horloge(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static Anneau *anneau_local(void) {
+    if (local && generation_locale == generation) return local;
+    Anneau *a = (Anneau*) malloc(sizeof(Anneau));
+    if (!a) return NULL;
+    a->total = 0;
+    pthread_mutex_lock(&verrou);
+    a->tid = ++nb_anneaux;
+    snprintf(a->nom, sizeof(a->nom), "thread %d", a->tid);
+    a->suivant = anneaux;
+    anneaux = a;
+    pthread_mutex_unlock(&verrou);
+    local = a;
+    generation_locale = generation;
+    return a;
+}
+
+int trace_start(const char *path) {
+    if (!path) return -1;
+    FILE *f = fopen(path, "w");   /* échouer tout de suite plutôt qu'à la fin */
+    if (!f) return -1;
+    fclose(f);
+    free(chemin);
+    chemin = strdup(path);
+    if (!chemin) return -1;
+    origine = trace_horloge();
+    trace_actif = 1;
+    return 0;
+}
+
+void trace_span(const char *nom, uint64_t debut, uint64_t arg) {
+    if (!trace_actif) return;
+    uint64_t fin = trace_horloge();
+    Anneau *a = anneau_local();
+    if (!a) return;
+    Intervalle *e = &a->ev[a->total & (TRACE_CAPACITE - 1)];
+    e->nom = nom;
+    e->debut = debut;
+    e->duree = fin - debut;
+    e->arg = arg;
+    a->total++;
+}
+
+void trace_nommer_thread(const char *nom) {
+    if (!trace_actif || !nom) return;
+    Anneau *a = anneau_local();
+    if (!a) return;
+    snprintf(a->nom, sizeof(a->nom), "%s", nom);
+}
+
+int trace_stop(void) {
+    if (!trace_actif) return 0;
+    trace_actif = 0;
+
+    FILE *f = fopen(chemin, "w");
+    int rc = f ? 0 : -1;
+    if (f) fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int premier = 1;
+    for (Anneau *a = anneaux; f && a; a = a->suivant) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                premier ? "" : ",\n", a->tid, a->nom);
+        premier = 0;
+        uint64_t n = (a->total < TRACE_CAPACITE) ? a->total : TRACE_CAPACITE;
+        for (uint64_t k = a->total - n; k < a->total; ++k) {
+            const Intervalle *e = &a->ev[k & (TRACE_CAPACITE - 1)];
+            uint64_t ts = (e->debut > origine) ? e->debut - origine : 0;
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                       "\"args\":{\"n\":%llu}}",
+                    e->nom, a->tid, (double) ts / 1000.0, (double) e->duree / 1000.0,
+                    (unsigned long long) e->arg);
+        }
+    }
+    if (f) {
+        fprintf(f, "\n]}\n");
+        if (ferror(f)) rc = -1;
+        if (fclose(f) != 0) rc = -1;
+    }
+
+    while (anneaux) {
+        Anneau *s = anneaux->suivant;
+        free(anneaux);
+        anneaux = s;
+    }
+    local = NULL;
+    generation++;
+    nb_anneaux = 0;
+    free(chemin);
+    chemin = NULL;
+    return rc;
+}
@@ -0,0 +1,53 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * trace.h
+ *
+ * Traces d'exécution au format Chrome trace-event (chrome://tracing,
+ * ui.perfetto.dev) : intervalles horodatés ("ph":"X") par phase du codec,
+ * par bloc et par thread.
+ *
+ * Chaque thread écrit dans son propre tampon circulaire (alloué à son premier
+ * intervalle, sans verrou ensuite) ; trace_stop() écrit le fichier JSON une
+ * fois le travail terminé. Quand la trace est inactive, TRACE_DEBUT /
+ * TRACE_FIN ne coûtent qu'un test ; compilé avec -DHF_NO_TRACE, plus rien.
+ *
+ *   TRACE_DEBUT(t);
+ *   ... phase ...
+ *   TRACE_FIN(t, "histogramme", n);   // nom : chaîne littérale, n : argument affiché
+ */
+
+#include <stdint.h>
+
+extern int trace_actif;
+
+/* Active la trace ; le fichier path est écrit par trace_stop().
+ * Retourne 0 si OK, -1 si path ne peut pas être créé.
+ */
+int trace_start(const char *path);
+
+/* Écrit les intervalles de tous les threads puis désactive la trace. À
+ * appeler quand plus aucun thread ne trace (après pool_destroy).
+ * Retourne 0 si OK (ou trace inactive), -1 en cas d'erreur d'écriture.
+ */
+int trace_stop(void);
+
+/* Horloge monotone en nanosecondes. */
+uint64_t trace_horloge(void);
+
+/* Enregistre l'intervalle [debut, maintenant) du thread appelant. */
+void trace_span(const char *nom, uint64_t debut, uint64_t arg);
+
+/* Nom du thread appelant dans la trace (copié). */
+void trace_nommer_thread(const char *nom);
+
+#ifdef HF_NO_TRACE
+#define TRACE_DEBUT(t)          ((void) 0)
+#define TRACE_FIN(t, nom, arg)  ((void) 0)
+#else
+#define TRACE_DEBUT(t)          uint64_t t = trace_actif ? trace_horloge() : 0
+#define TRACE_FIN(t, nom, arg)  do { if (t) trace_span((nom), (t), (uint64_t) (arg)); } while (0)
+#endif
+
+#endif /* TRACE_H */
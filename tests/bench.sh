@@ -0,0 +1,147 @@
+#!/bin/sh
+#
+# bench.sh
+#
+# Mesures de débit (make bench) :
+#   sh tests/bench.sh <binaire> <corpus> [section...]
+# Sections : kernels, decode, levels (défaut : toutes). H1=<binaire> : binaire à un
+# seul flux pour la section decode (make bench le compile). Tout est mesuré
+# sur un seul thread (-j 1), meilleur temps de BENCH_RUNS exécutions (défaut
+# 3) ; les débits sont rapportés à la taille d'origine. La section kernels
+# ignore les fichiers de moins de 1 Mio. Le chronométrage passe par
+# date +%s%N (GNU coreutils).
+
+set -u
+
+H=$1
+C=$2
+shift 2
+SECTIONS=${*:-kernels decode levels}
+H1=${H1:-}
+RUNS=${BENCH_RUNS:-3}
+T=$(mktemp -d "${TMPDIR:-/tmp}/hfbench.XXXXXX") || exit 1
+trap 'rm -rf "$T"' EXIT
+trap 'exit 1' INT TERM
+
+# chrono <commande...> : meilleur temps en microsecondes sur RUNS exécutions.
+chrono() {
+    meilleur=
+    i=0
+    while [ "$i" -lt "$RUNS" ]; do
+        d=$(date +%s%N)
+        "$@" >/dev/null 2>&1 || {
+            echo "échec : $*" >&2
+            return 1
+        }
+        e=$(date +%s%N)
+        t=$(((e - d) / 1000))
+        if [ -z "$meilleur" ] || [ "$t" -lt "$meilleur" ]; then meilleur=$t; fi
+        i=$((i + 1))
+    done
+    echo "$meilleur"
+}
+
+# debit <octets> <microsecondes> : MB/s (octets par microseconde).
+debit() {
+    awk -v o="$1" -v t="$2" 'BEGIN { printf "%.0f", (t > 0) ? o / t : 0 }'
+}
+
+taille() {
+    wc -c <"$1" | tr -d ' '
+}
+
+# ---------- Noyaux bit-à-bit ----------
+
+# Encodage Huffman (-1) et mode test avec chaque noyau ; les archives des
+# deux noyaux sont comparées octet pour octet (voir aussi tests/check.sh).
+bench_kernels() {
+    echo "== noyaux bit-à-bit (HUFFMAN_KERNEL), -1, -j 1 =="
+    printf '%-12s %-8s %10s %10s  %s\n' fichier noyau compression test archive
+    for f in "$C"/*; do
+        [ -f "$f" ] || continue
+        o=$(taille "$f")
+        [ "$o" -ge 1048576 ] || continue
+        for k in scalar bmi2; do
+            c=$(chrono env HUFFMAN_KERNEL=$k "$H" -j 1 -1 -c "$f" "$T/$k") || return 1
+            d=$(chrono env HUFFMAN_KERNEL=$k "$H" -j 1 -t "$T/$k") || return 1
+            printf '%-12s %-8s %5s MB/s %5s MB/s  %s\n' "$(basename "$f")" "$k" \
+                "$(debit "$o" "$c")" "$(debit "$o" "$d")" \
+                "$(cmp -s "$T/scalar" "$T/$k" && echo identique || echo DIFFÉRENTE)"
+        done
+    done
+}
+
+# ---------- Boucles de décodage ----------
+
+# Mode test de chaque largeur de code (w8.bin .. w11.bin, text.txt pour 12
+# bits) en 1 et 4 flux, boucles spécialisées (decode_tmpl.h) contre la boucle
+# générique (HUFFMAN_DECODE=generic) et le décodeur compact (canon.h). Sans somme de contrôle, pour ne mesurer
+# que le décodage. Les archives à un flux viennent de H1 (compilé avec un
+# HF_STREAMS_MIN énorme, voir le Makefile).
+bench_decode() {
+    echo "== boucles de décodage (HUFFMAN_DECODE), -t -j 1, --checksum none =="
+    if [ ! -x "$H1" ]; then
+        echo "(pas de binaire à un flux : lancer via make bench)"
+        return 0
+    fi
+    printf '%-9s %-8s %13s %13s %13s\n' largeur flux générique spécialisée compact
+    for w in 8 9 10 11 12; do
+        f=$C/w$w.bin
+        [ "$w" -eq 12 ] && f=$C/text.txt
+        if [ ! -f "$f" ]; then
+            echo "($f absent : section réservée au corpus généré)"
+            return 0
+        fi
+        o=$(taille "$f")
+        for ns in 1 4; do
+            if [ "$ns" -eq 1 ]; then b=$H1; else b=$H; fi
+            "$b" -j 1 --checksum none -c "$f" "$T/d" >/dev/null 2>&1 || return 1
+            g=$(chrono env HUFFMAN_DECODE=generic "$H" -j 1 -t "$T/d") || return 1
+            s=$(chrono "$H" -j 1 -t "$T/d") || return 1
+            k=$(chrono env HUFFMAN_DECODE=compact "$H" -j 1 -t "$T/d") || return 1
+            printf '%-9s %-8s %8s MB/s %8s MB/s %8s MB/s\n' "$w bits" "$ns" "$(debit "$o" "$g")" \
+                "$(debit "$o" "$s")" "$(debit "$o" "$k")"
+        done
+    done
+}
+
+# ---------- Niveaux ----------
+
+# Taux, compression et mode test de chaque niveau -1 .. -9, puis des réglages
+# écartés de la table des niveaux (hf_options_level, archive.c) : --codec
+# pairs et les efforts LZ77 5, 8 et 9. Sur text.txt et mix.bin, ou sur tous
+# les fichiers d'au moins 1 Mio d'un CORPUS=<dir>.
+bench_levels() {
+    echo "== niveaux, -j 1 =="
+    set -- "$C"/text.txt "$C"/mix.bin
+    [ -f "$1" ] || set -- "$C"/*
+    for f in "$@"; do
+        [ -f "$f" ] || continue
+        o=$(taille "$f")
+        [ "$o" -ge 1048576 ] || continue
+        echo "$(basename "$f") ($o octets)"
+        printf '  %-22s %8s %14s %14s\n' réglage taux compression test
+        for r in -1 -2 -3 -4 -5 -6 -7 -8 -9 "--codec pairs" "--codec lz --level 5" \
+                 "--codec lz --level 8" "--codec lz --level 9"; do
+            # $r non cité : une option et son argument
+            c=$(chrono "$H" -j 1 $r -c "$f" "$T/l") || return 1
+            d=$(chrono "$H" -j 1 -t "$T/l") || return 1
+            printf '  %-22s %7s%% %9s MB/s %9s MB/s\n' "$r" \
+                "$(awk -v a="$(taille "$T/l")" -v b="$o" 'BEGIN { printf "%.1f", 100 * a / b }')" \
+                "$(debit "$o" "$c")" "$(debit "$o" "$d")"
+        done
+    done
+}
+
+for s in $SECTIONS; do
+    case $s in
+        kernels) bench_kernels || exit 1 ;;
+        decode) bench_decode || exit 1 ;;
+        levels) bench_levels || exit 1 ;;
+        *)
+            echo "section inconnue : $s" >&2
+            exit 1
+            ;;
+    esac
+    echo
+done
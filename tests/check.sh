@@ -0,0 +1,124 @@
+#!/bin/sh
+#
+# check.sh
+#
+# Vérifications de bout en bout du binaire (make check) :
+#   sh tests/check.sh <binaire> <corpus>
+# Chaque fichier régulier de <corpus> (tests/corpus.c, ou CORPUS=<dir>)
+# passe par chaque section ; une ligne par section, puis le détail des
+# échecs. Code de sortie non nul si une vérification échoue.
+
+set -u
+
+H=$1
+C=$2
+T=$(mktemp -d "${TMPDIR:-/tmp}/hfcheck.XXXXXX") || exit 1
+trap 'rm -rf "$T"' EXIT
+trap 'exit 1' INT TERM
+
+echecs=0
+
+# section <nom> <fonction> <arguments...> : appelle <fonction> <arguments...>
+# <fichier> pour chaque fichier du corpus et compte les réussites.
+section() {
+    nom=$1
+    shift
+    ok=0
+    n=0
+    for f in "$C"/*; do
+        [ -f "$f" ] || continue
+        n=$((n + 1))
+        if "$@" "$f" >"$T/log" 2>&1; then
+            ok=$((ok + 1))
+        else
+            echecs=$((echecs + 1))
+            echo "  ÉCHEC $nom : $f" >>"$T/echecs"
+            tail -n 3 "$T/log" | sed 's/^/    /' >>"$T/echecs"
+        fi
+    done
+    printf '%-34s %d/%d\n' "$nom" "$ok" "$n"
+}
+
+# ---------- Aller-retour ----------
+
+# Compression séquentielle, décompression sur 1 et 4 threads, mode test.
+aller_retour() {
+    "$H" -j 1 "$1" -c "$2" "$T/a" &&
+        "$H" -j 1 -d "$T/a" "$T/o" && cmp "$2" "$T/o" &&
+        "$H" -j 4 -d "$T/a" "$T/o" && cmp "$2" "$T/o" &&
+        "$H" -j 4 -t "$T/a"
+}
+
+for niveau in -1 -2 -3 -4 -5 -6 -7 -8 -9; do
+    section "aller-retour $niveau" aller_retour "$niveau"
+done
+
+# Un --codec qui ne change pas le codec du niveau garde ses réglages (blocs
+# de 4 Mio de -9) : mêmes archives, octet pour octet.
+meme_codec() {
+    "$H" -j 1 "$1" -c "$3" "$T/n" && "$H" -j 1 "$1" --codec "$2" -c "$3" "$T/m" && cmp "$T/n" "$T/m"
+}
+
+section "-9 --codec bwt = -9" meme_codec -9 bwt
+section "-3 --codec lz = -3" meme_codec -3 lz
+
+# ---------- Noyaux bit-à-bit ----------
+
+# Les noyaux scalar et bmi2 (bitkernels.h) doivent écrire les mêmes archives,
+# octet pour octet, et chacun relire celles de l'autre.
+noyaux() {
+    HUFFMAN_KERNEL=scalar "$H" -j 1 "$1" -c "$2" "$T/s" &&
+        HUFFMAN_KERNEL=bmi2 "$H" -j 1 "$1" -c "$2" "$T/b" && cmp "$T/s" "$T/b" &&
+        HUFFMAN_KERNEL=scalar "$H" -j 1 -d "$T/b" "$T/o" && cmp "$2" "$T/o" &&
+        HUFFMAN_KERNEL=bmi2 "$H" -j 1 -d "$T/s" "$T/o" && cmp "$2" "$T/o"
+}
+
+if ! grep -qw bmi2 /proc/cpuinfo 2>/dev/null; then
+    echo "(processeur sans BMI2 : HUFFMAN_KERNEL=bmi2 retombe sur le noyau scalar)"
+fi
+for niveau in -1 -2; do
+    section "noyaux scalar = bmi2 $niveau" noyaux "$niveau"
+done
+
+# ---------- Décodeurs ----------
+
+# Les mêmes archives décodées par les boucles spécialisées, la boucle
+# générique (HUFFMAN_DECODE=generic) et le décodeur compact (canon.h) :
+# trois sorties identiques à l'original, sur 1 et 4 threads.
+decodeurs() {
+    "$H" -j 1 "$1" -c "$2" "$T/a" &&
+        "$H" -j 1 -d "$T/a" "$T/o" && cmp "$2" "$T/o" &&
+        HUFFMAN_DECODE=generic "$H" -j 1 -d "$T/a" "$T/g" && cmp "$T/o" "$T/g" &&
+        HUFFMAN_DECODE=compact "$H" -j 1 -d "$T/a" "$T/c" && cmp "$T/o" "$T/c" &&
+        HUFFMAN_DECODE=compact "$H" -j 4 -d "$T/a" "$T/c" && cmp "$T/o" "$T/c" &&
+        HUFFMAN_DECODE=compact "$H" -j 4 -t "$T/a"
+}
+
+for niveau in -1 -2; do
+    section "décodeurs compact = generic $niveau" decodeurs "$niveau"
+done
+
+# ---------- Ajouts ----------
+
+# Deux ajouts -1 (300 Ko puis 1,5 Mo du même fichier), puis décodage sur 1 et
+# 4 threads : un segment parallèle peut commencer dans une chaîne de blocs qui
+# reprennent la table d'un bloc à 4 flux (HF_BLOCK_4STREAMS).
+ajouts() {
+    head -c 300000 "$1" >"$T/p1" && head -c 1500000 "$1" >"$T/p2" &&
+        cat "$1" "$T/p1" "$T/p2" >"$T/r" &&
+        "$H" -1 -c "$1" "$T/a" && "$H" -1 -a "$T/p1" "$T/a" && "$H" -1 -a "$T/p2" "$T/a" &&
+        "$H" -j 1 -d "$T/a" "$T/o" && cmp "$T/r" "$T/o" &&
+        "$H" -j 4 -d "$T/a" "$T/o" && cmp "$T/r" "$T/o" &&
+        "$H" -j 4 -t "$T/a"
+}
+
+section "ajouts puis décodage parallèle" ajouts
+
+# ---------- Bilan ----------
+
+if [ "$echecs" -ne 0 ]; then
+    cat "$T/echecs"
+    echo "$echecs vérification(s) en échec"
+    exit 1
+fi
+echo "OK"
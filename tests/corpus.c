@@ -0,0 +1,193 @@
+/*
+ * corpus.c
+ *
+ * Corpus déterministe pour make check / make bench (tests/check.sh,
+ * tests/bench.sh) : mêmes octets sur toutes les machines, rien à télécharger.
+ *
+ * Usage : corpus <répertoire> [taille]   (taille par fichier, défaut 4 Mio)
+ *
+ * Fichiers écrits :
+ * - text.txt : lignes de journal et de source C entremêlées (codes jusqu'à
+ *   12 bits, comme le mélange de logs et de sources des mesures du README) ;
+ * - mix.bin  : morceaux de 64 Kio à 512 Kio de texte, de zéros, d'octets
+ *   aléatoires et d'entiers binaires, pour le découpage adaptatif ;
+ * - w8.bin .. w11.bin : symboles tirés d'une loi dyadique dont le code de
+ *   Huffman a exactement cette longueur maximale (largeurs des boucles de
+ *   décodage spécialisées, voir decode_tmpl.h) ;
+ * - empty.bin, one.bin, zero.bin, rand.bin : cas limites (vide, un octet,
+ *   un seul symbole, incompressible).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* xorshift64* : même suite partout, quelle que soit la libc */
+static uint64_t etat = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t aleatoire(void) {
+    etat ^= etat >> 12;
+    etat ^= etat << 25;
+    etat ^= etat >> 27;
+    return etat * 0x2545F4914F6CDD1DULL;
+}
+
+static uint32_t tirer(uint32_t n) {
+    return (uint32_t) ((aleatoire() >> 32) % n);
+}
+
+/* ---------- Texte ---------- */
+
+static const char *const niveaux_log[] = {"INFO ", "INFO ", "INFO ", "DEBUG", "WARN ", "ERROR"};
+static const char *const methodes[] = {"GET", "GET", "GET", "POST", "PUT", "DELETE"};
+static const char *const chemins[] = {"/api/v1/items", "/api/v1/users", "/api/v1/orders", "/static/app.js",
+                                      "/static/style.css", "/health", "/metrics", "/api/v2/search"};
+static const char *const messages[] = {
+    "échec de la décompression : bloc corrompu", "fichier introuvable", "délai dépassé",
+    "mémoire insuffisante ; nouvel essai", "requête refusée : quota atteint", "clé déjà présente"};
+static const char *const mots[] = {
+    "if", "return", "for", "while", "const", "static", "int", "size_t", "char", "unsigned", "void",
+    "struct", "NULL", "sizeof", "else", "break", "uint64_t", "uint32_t", "buf", "len", "pos", "n",
+    "out", "in", "rc", "table", "bloc", "taille", "code", "symbole", "flux", "index", "entree",
+    "sortie", "lire", "ecrire", "decoder", "encoder", "hf_malloc", "hf_free", "memcpy", "memset"};
+#define NB(t) (sizeof(t) / sizeof((t)[0]))
+
+/* Écrit au plus cap octets d'une ligne de journal ou de source dans p. */
+static size_t ligne(char *p, size_t cap) {
+    char l[256];
+    int n;
+    if (tirer(40) == 0) {
+        /* message d'erreur : accents (octets UTF-8 rares), guillemets, ponctuation */
+        n = snprintf(l, sizeof(l), "2026-10-18 ERROR %s (« %s ») | code=0x%04X\n", messages[tirer(NB(messages))],
+                     tirer(2) ? "config.json" : "~/data/#42", tirer(65536));
+    } else if (tirer(3) != 0) {
+        unsigned s = tirer(86400);
+        n = snprintf(l, sizeof(l), "2026-10-18 %02u:%02u:%02u.%03u %s [worker-%u] %s %s/%u took %u ms status=%u\n",
+                     s / 3600, s / 60 % 60, s % 60, tirer(1000), niveaux_log[tirer(NB(niveaux_log))],
+                     tirer(8), methodes[tirer(NB(methodes))], chemins[tirer(NB(chemins))], tirer(100000),
+                     1 + tirer(250), tirer(10) ? 200u : 500u);
+    } else {
+        /* indentation puis quelques mots : mots fréquents en tête de liste */
+        n = snprintf(l, sizeof(l), "%*s", 4 * (int) tirer(4), "");
+        unsigned k = 2 + tirer(7);
+        for (unsigned i = 0; i < k && n < 200; ++i) {
+            unsigned m = tirer(NB(mots));
+            m = (m < tirer(NB(mots))) ? m : tirer(NB(mots)); /* biais vers le début */
+            n += snprintf(l + n, sizeof(l) - (size_t) n, "%s%s", mots[m],
+                          (i + 1 < k) ? (tirer(4) ? " " : ", ") : (tirer(3) ? ";\n" : " {\n"));
+        }
+    }
+    size_t len = (size_t) n < cap ? (size_t) n : cap;
+    memcpy(p, l, len);
+    return len;
+}
+
+static void texte(unsigned char *b, size_t n) {
+    size_t i = 0;
+    while (i < n) i += ligne((char*) b + i, n - i);
+}
+
+/* ---------- Mélange ---------- */
+
+static void melange(unsigned char *b, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        size_t m = (64u << 10) << tirer(4);
+        if (m > n - i) m = n - i;
+        switch (tirer(4)) {
+            case 0: texte(b + i, m); break;
+            case 1: memset(b + i, 0, m); break;
+            case 2:
+                for (size_t k = 0; k < m; ++k) b[i + k] = (unsigned char) aleatoire();
+                break;
+            default:
+                /* entiers 32 bits petit-boutistes croissants : octets de poids fort presque nuls */
+                for (size_t k = 0; k < m; ++k) b[i + k] = (unsigned char) (((i + k) / 4 * 37) >> (8 * ((i + k) % 4)));
+                break;
+        }
+        i += m;
+    }
+}
+
+/* ---------- Lois dyadiques ---------- */
+
+/* (nombre de symboles, longueur de code) : la somme des 2^-longueur vaut 1,
+ * donc le code de Huffman optimal a exactement ces longueurs. */
+typedef struct Groupe {
+    int symboles, longueur;
+} Groupe;
+
+static const Groupe lois[4][6] = {
+    {{32, 6}, {128, 8}},                            /* 8 bits */
+    {{32, 6}, {64, 8}, {128, 9}},                   /* 9 bits */
+    {{32, 6}, {96, 8}, {32, 9}, {64, 10}},          /* 10 bits */
+    {{32, 6}, {96, 8}, {32, 9}, {32, 10}, {64, 11}} /* 11 bits */
+};
+
+static void dyadique(unsigned char *b, size_t n, int largeur) {
+    /* chaque symbole occupe 2^(largeur - longueur) cases d'une table de 2^largeur */
+    unsigned char *cases = (unsigned char*) malloc((size_t) 1 << largeur);
+    if (!cases) return;
+    size_t k = 0;
+    int s = 0;
+    for (const Groupe *g = lois[largeur - 8]; g->symboles; ++g) {
+        for (int i = 0; i < g->symboles; ++i, ++s) {
+            for (size_t c = 0; c < ((size_t) 1 << (largeur - g->longueur)); ++c) cases[k++] = (unsigned char) s;
+        }
+    }
+    const uint64_t masque = ((uint64_t) 1 << largeur) - 1;
+    for (size_t i = 0; i < n; ++i) b[i] = cases[(aleatoire() >> 40) & masque];
+    free(cases);
+}
+
+/* ---------- Écriture ---------- */
+
+static int ecrire(const char *dir, const char *nom, const unsigned char *b, size_t n) {
+    char chemin[4096];
+    snprintf(chemin, sizeof(chemin), "%s/%s", dir, nom);
+    FILE *f = fopen(chemin, "wb");
+    if (!f) {
+        perror(chemin);
+        return -1;
+    }
+    int rc = (fwrite(b, 1, n, f) == n) ? 0 : -1;
+    if (fclose(f) != 0) rc = -1;
+    if (rc != 0) perror(chemin);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage : %s <répertoire> [taille]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *dir = argv[1];
+    size_t n = (argc == 3) ? (size_t) strtoull(argv[2], NULL, 10) : ((size_t) 4 << 20);
+    if (n < 16) n = 16;
+    unsigned char *b = (unsigned char*) malloc(n);
+    if (!b) return EXIT_FAILURE;
+
+    int rc = 0;
+    texte(b, n);
+    rc |= ecrire(dir, "text.txt", b, n);
+    melange(b, n);
+    rc |= ecrire(dir, "mix.bin", b, n);
+    for (int w = 8; w <= 11; ++w) {
+        char nom[16];
+        snprintf(nom, sizeof(nom), "w%d.bin", w);
+        dyadique(b, n, w);
+        rc |= ecrire(dir, nom, b, n);
+    }
+    rc |= ecrire(dir, "empty.bin", b, 0);
+    rc |= ecrire(dir, "one.bin", (const unsigned char*) "x", 1);
+    memset(b, 0, n / 4);
+    rc |= ecrire(dir, "zero.bin", b, n / 4);
+    for (size_t i = 0; i < n / 4; ++i) b[i] = (unsigned char) aleatoire();
+    rc |= ecrire(dir, "rand.bin", b, n / 4);
+
+    free(b);
+    return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}